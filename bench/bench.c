@@ -0,0 +1,489 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "editor.h"
+
+/*
+ * Runs editing scenarios on the headless core and reports throughput,
+ * latency percentiles and peak RSS for each. Every run of a scenario is
+ * a fresh child process that opens the file and times the operations it
+ * is about; the child sends its samples back through a pipe, and its
+ * peak RSS comes from wait4, so runs cannot disturb each other.
+ */
+#define BENCH_SCREEN_ROWS 24
+#define BENCH_SAMPLES_MAX 4096
+#define BENCH_KEYS 2000
+#define BENCH_PASTES 100
+#define BENCH_PASTE_ROWS 1000
+
+typedef struct
+{
+    const char *name;
+    /* fills samples (ms) and the bytes they moved, returns their count */
+    int (*run)(const char *path, double *samples, double *bytes);
+} BenchScenario;
+
+typedef struct
+{
+    double samples[BENCH_SAMPLES_MAX];
+    int n;
+    double bytes;
+    long rss;
+} BenchResult;
+
+static const char *benchDir;
+
+static void benchOpen(const char *path)
+{
+    editorOpen((char *)path);
+    editorIndexFinish();
+}
+
+static int benchRunOpen(const char *path, double *samples, double *bytes)
+{
+    struct stat st;
+    double t = statsNow();
+
+    benchOpen(path);
+    samples[0] = statsNow() - t;
+    stat(path, &st);
+    *bytes = st.st_size;
+    return 1;
+}
+
+/* Types BENCH_KEYS chars into row `at`, each a keystroke of its own. */
+static int benchType(int at, double *samples, double *bytes)
+{
+    int i;
+
+    for (i = 0; i < BENCH_KEYS; i++)
+    {
+        double t = statsNow();
+        undoBegin(&E.undo, i, at);
+        editorInsertText(at, i, "x", 1);
+        samples[i] = statsNow() - t;
+    }
+    *bytes = 0;
+    return BENCH_KEYS;
+}
+
+static int benchRunInsertTop(const char *path, double *samples, double *bytes)
+{
+    benchOpen(path);
+    return benchType(0, samples, bytes);
+}
+
+static int benchRunInsertMiddle(
+    const char *path,
+    double *samples,
+    double *bytes
+)
+{
+    benchOpen(path);
+    return benchType(E.numrows / 2, samples, bytes);
+}
+
+static int benchRunInsertEnd(const char *path, double *samples, double *bytes)
+{
+    benchOpen(path);
+    return benchType(E.numrows - 1, samples, bytes);
+}
+
+/* Pastes BENCH_PASTE_ROWS yanked rows at rows spread over the file. */
+static int benchRunPaste(const char *path, double *samples, double *bytes)
+{
+    int n;
+    int i;
+
+    benchOpen(path);
+    n = E.numrows < BENCH_PASTE_ROWS ? E.numrows : BENCH_PASTE_ROWS;
+    editorYankRows(0, n);
+    *bytes = 0;
+    for (i = 0; i < BENCH_PASTES; i++)
+    {
+        double t;
+        E.cy = (int)((double)E.numrows * i / BENCH_PASTES);
+        E.cx = 0;
+        t = statsNow();
+        undoBegin(&E.undo, E.cx, E.cy);
+        editorPaste(1, 1);
+        samples[i] = statsNow() - t;
+        *bytes += editorRowsLength(E.cy, n) + 1;
+    }
+    return BENCH_PASTES;
+}
+
+/* Counts every match of a literal and of a regex query over the file. */
+static int benchRunSearch(const char *path, double *samples, double *bytes)
+{
+    static const char *queries[] = {"error", "served in 4", "[0-9]+ms"};
+    struct stat st;
+    int i;
+
+    benchOpen(path);
+    stat(path, &st);
+    for (i = 0; i < 3; i++)
+    {
+        double t = statsNow();
+        E.use_regex = i == 2;
+        editorFindSet(queries[i]);
+        while (E.counting)
+        {
+            struct timespec pause = {0, 100000};
+            nanosleep(&pause, NULL);
+            editorFindPoll();
+        }
+        samples[i] = statsNow() - t;
+    }
+    *bytes = 3.0 * st.st_size;
+    return 3;
+}
+
+/* Runs :%s over the whole file and back again. */
+static int benchRunReplace(const char *path, double *samples, double *bytes)
+{
+    static const char *commands[] = {"%s/e/E/g", "%s/E/e/g"};
+    struct stat st;
+    int i;
+
+    benchOpen(path);
+    stat(path, &st);
+    for (i = 0; i < 2; i++)
+    {
+        double t = statsNow();
+        undoBegin(&E.undo, E.cx, E.cy);
+        editorExecute(commands[i]);
+        samples[i] = statsNow() - t;
+    }
+    *bytes = 2.0 * st.st_size;
+    return 2;
+}
+
+/* Saves an edited copy of the file next to the synthetic one. */
+static int benchRunSave(const char *path, double *samples, double *bytes)
+{
+    struct stat st;
+    char *out = malloc(strlen(benchDir) + 16);
+    int i;
+
+    benchOpen(path);
+    editorInsertText(E.numrows / 2, 0, "x", 1);
+    sprintf(out, "%s/saved.txt", benchDir);
+    free(E.filename);
+    E.filename = out;
+    *bytes = 0;
+    for (i = 0; i < 3; i++)
+    {
+        double t = statsNow();
+        editorSave();
+        samples[i] = statsNow() - t;
+        stat(out, &st);
+        *bytes += st.st_size;
+    }
+    unlink(out);
+    return 3;
+}
+
+static const BenchScenario benchScenarios[] = {
+    {"open", benchRunOpen},
+    {"insert-top", benchRunInsertTop},
+    {"insert-middle", benchRunInsertMiddle},
+    {"insert-end", benchRunInsertEnd},
+    {"paste", benchRunPaste},
+    {"search", benchRunSearch},
+    {"replace", benchRunReplace},
+    {"save", benchRunSave},
+};
+
+/*
+ * Runs one scenario in a child and adds its samples to `res`. The child
+ * writes the count, the bytes and the samples and exits without tearing
+ * anything down.
+ */
+static void benchChild(
+    const BenchScenario *s,
+    const char *path,
+    BenchResult *res
+)
+{
+    static double samples[BENCH_SAMPLES_MAX];
+    struct rusage ru;
+    double bytes = 0;
+    int fds[2];
+    int status;
+    int n = 0;
+    pid_t pid;
+
+    if (pipe(fds) == -1)
+    {
+        die("pipe");
+    }
+    pid = fork();
+    if (pid == -1)
+    {
+        die("fork");
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        editorInit(BENCH_SCREEN_ROWS);
+        n = s->run(path, samples, &bytes);
+        if (write(fds[1], &n, sizeof(n)) != sizeof(n) ||
+            write(fds[1], &bytes, sizeof(bytes)) != sizeof(bytes) ||
+            write(fds[1], samples, sizeof(double) * n) !=
+                (ssize_t)(sizeof(double) * n))
+        {
+            _exit(1);
+        }
+        _exit(0);
+    }
+
+    close(fds[1]);
+    if (read(fds[0], &n, sizeof(n)) == sizeof(n) &&
+        read(fds[0], &bytes, sizeof(bytes)) == sizeof(bytes))
+    {
+        size_t want = sizeof(double) * n;
+        size_t got = 0;
+        ssize_t r;
+        while (got < want &&
+               (r = read(fds[0], (char *)samples + got, want - got)) > 0)
+        {
+            got += r;
+        }
+        n = got / sizeof(double);
+    }
+    else
+    {
+        n = 0;
+    }
+    close(fds[0]);
+    if (wait4(pid, &status, 0, &ru) == -1 || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0)
+    {
+        fprintf(stderr, "%s: run failed\n", s->name);
+        return;
+    }
+
+    if (n > BENCH_SAMPLES_MAX - res->n)
+    {
+        n = BENCH_SAMPLES_MAX - res->n;
+    }
+    memcpy(&res->samples[res->n], samples, sizeof(double) * n);
+    res->n += n;
+    res->bytes += bytes;
+    if (ru.ru_maxrss > res->rss)
+    {
+        res->rss = ru.ru_maxrss;
+    }
+}
+
+static void benchReport(const char *name, BenchResult *res)
+{
+    char rate[32];
+    double total = 0;
+    int i;
+
+    if (!res->n)
+    {
+        printf("%-14s %8s\n", name, "failed");
+        return;
+    }
+    statsSort(res->samples, res->n);
+    for (i = 0; i < res->n; i++)
+    {
+        total += res->samples[i];
+    }
+    if (res->bytes > 0)
+    {
+        sprintf(rate, "%.1f MB/s", res->bytes / (total * 1e3));
+    }
+    else
+    {
+        sprintf(rate, "%.0f ops/s", res->n / (total / 1e3));
+    }
+    printf(
+        "%-14s %8d %11.1f %14s %9.3f %9.3f %9.3f %8.1f MB\n",
+        name,
+        res->n,
+        total,
+        rate,
+        statsPercentile(res->samples, res->n, 50),
+        statsPercentile(res->samples, res->n, 99),
+        res->samples[res->n - 1],
+        res->rss / 1024.0
+    );
+}
+
+/*
+ * Writes about `mb` megabytes of log lines, tab-indented code and error
+ * lines in a fixed pseudo-random mix, so every run sees the same file.
+ */
+static void benchSynthesize(const char *path, long mb)
+{
+    FILE *fp = fopen(path, "w");
+    unsigned long seed = 12345;
+    long size = 0;
+    long i = 0;
+
+    if (!fp)
+    {
+        die("fopen");
+    }
+    while (size < mb * 1024 * 1024)
+    {
+        int kind;
+        int n;
+        seed = seed * 1103515245 + 12345;
+        kind = (seed >> 16) % 10;
+        if (kind < 7)
+        {
+            n = fprintf(
+                fp,
+                "2024-05-%02lu %02lu:%02lu INFO request %ld served in %lums "
+                "user=u%lu path=/api/items/%lu\n",
+                seed % 28 + 1,
+                seed / 7 % 24,
+                seed / 11 % 60,
+                i,
+                seed / 13 % 900,
+                seed / 17 % 5000,
+                seed / 19 % 100000
+            );
+        }
+        else if (kind < 9)
+        {
+            n = fprintf(
+                fp,
+                "\tif (count > %lu) { total += count; } /* bounds */\n",
+                seed / 7 % 1000
+            );
+        }
+        else
+        {
+            n = fprintf(
+                fp,
+                "ERROR request %ld failed: error after %lums\n",
+                i,
+                seed / 7 % 9000
+            );
+        }
+        size += n;
+        i++;
+    }
+    fclose(fp);
+}
+
+static void benchFile(const char *path, int runs)
+{
+    struct stat st;
+    size_t k;
+
+    if (stat(path, &st) == -1)
+    {
+        perror(path);
+        return;
+    }
+    printf("%s (%.1f MB)\n", path, st.st_size / (1024.0 * 1024.0));
+    printf(
+        "%-14s %8s %11s %14s %9s %9s %9s %11s\n",
+        "scenario",
+        "samples",
+        "total ms",
+        "throughput",
+        "p50 ms",
+        "p99 ms",
+        "max ms",
+        "peak RSS"
+    );
+    for (k = 0; k < sizeof(benchScenarios) / sizeof(*benchScenarios); k++)
+    {
+        BenchResult *res = calloc(1, sizeof(BenchResult));
+        int r;
+        for (r = 0; r < runs; r++)
+        {
+            benchChild(&benchScenarios[k], path, res);
+        }
+        benchReport(benchScenarios[k].name, res);
+        free(res);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    char dir[] = "/tmp/ocean_bench.XXXXXX";
+    char *synthetic;
+    long mb = 64;
+    int runs = 3;
+    int c;
+
+    while ((c = getopt(argc, argv, "m:r:")) != -1)
+    {
+        switch (c)
+        {
+        case 'm':
+            mb = atol(optarg);
+            break;
+        case 'r':
+            runs = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-m MB] [-r runs] [file...]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (mb < 1 || runs < 1)
+    {
+        fprintf(stderr, "%s: -m and -r must be positive\n", argv[0]);
+        return 2;
+    }
+
+    if (!mkdtemp(dir))
+    {
+        die("mkdtemp");
+    }
+    benchDir = dir;
+    synthetic = malloc(strlen(dir) + 16);
+    sprintf(synthetic, "%s/synthetic.txt", dir);
+    benchSynthesize(synthetic, mb);
+    benchFile(synthetic, runs);
+    for (c = optind; c < argc; c++)
+    {
+        benchFile(argv[c], runs);
+    }
+
+    unlink(synthetic);
+    rmdir(dir);
+    free(synthetic);
+    return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OCEAN_BUFFER_H
+#define OCEAN_BUFFER_H
+
+/* chars points into a read-only file mapping rather than owned memory */
+#define ROW_VIEW 1
+
+/* the render is the row's chars, as it has no tabs */
+#define RENDER_SHARED 1
+/* every column is HL_NORMAL, so no hl is kept */
+#define RENDER_PLAIN 2
+
+typedef struct Erow Erow;
+typedef struct Erender Erender;
+
+/*
+ * How a row looks on screen, built when it is first drawn: the header is
+ * followed by the render with tabs expanded and then one hl byte per
+ * render column, each left out when its flag says it is not needed. The
+ * header also links the render into the editor's list of cached renders,
+ * oldest drawn first, and points back at its row; the buffer keeps that
+ * pointer right whenever it moves rows.
+ */
+struct Erender
+{
+    int rsize;
+    int flags;
+    unsigned int frame;
+    Erow *row;
+    Erender *prev;
+    Erender *next;
+};
+
+/*
+ * A row keeps only what every pass over the buffer reads; the screen
+ * form is one pointer away, and NULL until the row is drawn.
+ */
+struct Erow
+{
+    char *chars;
+    Erender *render;
+    int size;
+    int matches;
+    unsigned char flags;
+    unsigned char hl_state;
+};
+
+/*
+ * Rows are kept in a counted B+ tree: leaves hold a run of rows, inner
+ * nodes record how many rows live below each child. Finding, inserting or
+ * deleting line N walks a single root-to-leaf path, so edits cost
+ * O(log n) regardless of where in the file they happen. The rows' search
+ * match counts are summed the same way, which turns "which match is
+ * this" and "where is match k" into single descents too.
+ */
+#define BUFFER_LEAF_ROWS 128
+#define BUFFER_FANOUT 32
+
+typedef struct BufferNode BufferNode;
+typedef struct BufferLeaf BufferLeaf;
+
+struct BufferNode
+{
+    int leaf;
+    int count;
+    int lines;
+    int matches;
+};
+
+struct BufferLeaf
+{
+    BufferNode node;
+    BufferLeaf *prev;
+    BufferLeaf *next;
+    Erow rows[BUFFER_LEAF_ROWS];
+};
+
+typedef struct
+{
+    BufferNode node;
+    BufferNode *child[BUFFER_FANOUT];
+} BufferInner;
+
+typedef struct
+{
+    BufferNode *root;
+    int numrows;
+} Buffer;
+
+typedef struct
+{
+    BufferLeaf *leaf;
+    int idx;
+} BufferIter;
+
+void bufferInit(Buffer *buf);
+void bufferFree(Buffer *buf);
+void bufferInsert(Buffer *buf, int at, const Erow *rows, int n);
+void bufferDelete(Buffer *buf, int at, int n);
+void bufferFilter(Buffer *buf, int from, int n, const unsigned char *drop);
+Erow *bufferGet(Buffer *buf, int at);
+
+void bufferSetMatches(Buffer *buf, int at, int matches);
+void bufferSumMatches(Buffer *buf);
+int bufferMatchRank(Buffer *buf, int at);
+int bufferMatchSelect(Buffer *buf, int k, int *nth);
+
+void bufferIterInit(Buffer *buf, BufferIter *it, int at);
+Erow *bufferIterNext(BufferIter *it);
+Erow *bufferIterPrev(BufferIter *it);
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OCEAN_DFA_H
+#define OCEAN_DFA_H
+
+#include <stddef.h>
+
+/*
+ * Regular expressions run as DFAs built lazily from a Thompson NFA: a
+ * DFA state is created the first time a set of NFA states is reached and
+ * its transitions are filled in as they are taken. Every byte is looked
+ * at a bounded number of times, whatever the pattern, and the state cache
+ * is flushed when it grows past DFA_MAX_STATES.
+ *
+ * Supported syntax: literals, `.`, `[...]` classes with ranges and `^`
+ * negation, `\d \w \s` and their negations `\D \W \S`, `\` escapes,
+ * grouping with `( )`, `|`, `*`, `+`, `?`, and the row anchors `^` `$`.
+ */
+#define DFA_MAX_STATES 2048
+
+typedef struct Regex Regex;
+
+typedef struct
+{
+    const Regex *re;
+    int entry;
+    int leftmost;
+    int start;
+    int nstates;
+    int capacity;
+    int *next;
+    unsigned char *accept;
+    int **sets;
+    int *lengths;
+    int *table;
+    int table_size;
+    int *mark;
+    int gen;
+    int *stack;
+    int *scratch;
+    int *pruned;
+    int *pruned_by;
+    int flushes;
+} Dfa;
+
+/*
+ * Automaton caches for one thread; they cannot be shared. A matcher
+ * works on one row at a time, set with regexMatcherRow, and `live` holds
+ * for each of its positions which threads can still reach a match there.
+ */
+typedef struct
+{
+    Dfa forward;
+    Dfa reverse;
+    Dfa live;
+    const char *row;
+    int size;
+    int *lives;
+    int fence;
+    int capacity;
+} RegexMatcher;
+
+Regex *regexCompile(const char *pattern, size_t len, const char **error);
+void regexFree(Regex *re);
+int regexMatchesEmpty(const Regex *re, int begin, int end);
+void regexMatcherInit(RegexMatcher *m, const Regex *re);
+void regexMatcherFree(RegexMatcher *m);
+void regexMatcherRow(RegexMatcher *m, const char *s, int size);
+int regexFind(RegexMatcher *m, int from, int *start, int *end);
+
+#endif
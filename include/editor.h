@@ -0,0 +1,199 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OCEAN_EDITOR_H
+#define OCEAN_EDITOR_H
+
+#include <stddef.h>
+#include <sys/uio.h>
+#include <time.h>
+
+#include "buffer.h"
+#include "lineindex.h"
+#include "search.h"
+#include "slab.h"
+#include "stats.h"
+#include "syntax.h"
+#include "undo.h"
+
+/*
+ * The editor without a terminal: the document, its edits and undo, search,
+ * the ex commands, loading and saving, all acting on the one global E. The
+ * curses front end in main.c reads keys into these and draws what E holds;
+ * anything else, such as the benchmark, can drive them the same way.
+ */
+#define TABSTOP 2
+
+typedef enum
+{
+    NORMAL,
+    INSERT,
+    VISUAL_CHAR
+} Mode;
+
+/* yanked text; linewise text is whole rows joined by newlines */
+typedef struct
+{
+    char *text;
+    size_t len;
+    int linewise;
+} Register;
+
+/* the unnamed register and a-z */
+#define REGISTERS 27
+
+typedef struct
+{
+    int cx, cy;
+    int rx;
+    int rowoff;
+    int coloff;
+    int screenrows;
+    int numrows;
+    Buffer buf;
+    int dirty;
+    char *filename;
+    char *map;
+    size_t map_size;
+    LineIndex index;
+    int indexing;
+    int indexed;
+    size_t cache_bytes;
+    Erender *render_oldest;
+    Erender *render_newest;
+    unsigned int render_frame;
+    const EditorSyntax *syntax;
+    int hl_valid;
+    SearchPool search;
+    int searching;
+    char *query;
+    SearchPattern pattern;
+    SearchMatcher matcher;
+    Regex *regex;
+    int use_regex;
+    const char *regex_error;
+    int counting;
+    int match_ready;
+    UndoLog undo;
+    Slab slab;
+    char statusmsg[80];
+    time_t statusmsg_time;
+    Mode mode;
+    int selection_x, selection_y;
+    unsigned char *damage;
+    int drawn_rowoff;
+    int drawn_coloff;
+    int drawn_cols;
+    int drawn_cy;
+    Mode drawn_mode;
+    Register registers[REGISTERS];
+    int reg;
+    int unnamed;
+    int count;
+    int op;
+    int opcount;
+    int pending;
+    int quit;
+    int stats_shown;
+} Editor;
+
+extern Editor E;
+
+void die(const char *s);
+void editorInit(int screenrows);
+void editorSetStatusMessage(const char *fmt, ...);
+
+void editorDamageRows(int from, int to);
+void editorDamageAll(void);
+int editorRowCxToRx(Erow *row, int cx);
+int editorRowRxToCx(Erow *row, int rx);
+void editorRowInvalidate(Erow *row);
+int editorRenderSize(const Erow *row);
+const char *editorRenderChars(const Erow *row);
+const unsigned char *editorRenderHl(const Erow *row);
+void editorUpdateRow(Erow *row);
+void editorRowRender(Erow *row);
+void editorTrimCache(void);
+void editorSyntaxPrepare(int upto);
+void editorSyntaxUpdate(int from, int to);
+void editorSyntaxRowsInserted(int at, int n);
+void editorSyntaxRowsDeleted(int at, int n);
+void editorSelectSyntax(void);
+
+void editorRowMakeOwned(Erow *row);
+void editorRowModify(Erow *row);
+void editorRowInsertString(Erow *row, int at, const char *s, size_t len);
+void editorRowAppendString(Erow *row, char *s, size_t len);
+void editorRowDelString(Erow *row, int at, int len);
+void editorFreeRow(Erow *row);
+void editorInsertRows(int at, const char *text, size_t len, int n);
+void editorInsertRow(int at, char *s, size_t len);
+size_t editorRowsLength(int at, int n);
+void editorRowsCopy(int at, int n, char *dst);
+void editorDelRows(int at, int n);
+void editorDelRow(int at);
+void editorInsertText(int at, int col, const char *s, size_t len);
+void editorDeleteText(int at, int col, int len);
+void editorSplitRow(int at, int col);
+void editorJoinRow(int at);
+void editorSpliceText(
+    int at,
+    int col,
+    const char *text,
+    size_t len,
+    int *end_at,
+    int *end_col
+);
+char *editorRangeText(int fy, int fx, int ty, int tx, size_t *len);
+void editorDeleteRange(int fy, int fx, int ty, int tx);
+void editorShiftRows(int from, int to, int direction);
+void editorInsertChar(int c);
+void editorDelChar(void);
+void editorInsertNewline(void);
+void editorRegisterStore(char *text, size_t len, int linewise);
+void editorYankRows(int at, int n);
+void editorPaste(int after, int count);
+void editorPasteText(char *text, size_t len);
+int editorUndo(int direction);
+void editorClampCursor(void);
+void editorExecute(const char *line);
+int editorStatsLine(int k, char *buf, size_t size);
+int editorStatsDump(const char *path);
+
+void editorIngest(int limit);
+void editorIndexFinish(void);
+void editorRowsNeeded(int n);
+int editorTotalRows(void);
+void editorOpenMapping(char *map, size_t size);
+void editorOpen(char *filename);
+int editorWritev(int fd, struct iovec *iov, int n);
+int editorWriteRows(int fd, size_t *written);
+void editorSave(void);
+
+int editorCountMatches(const char *s, int size, int limit);
+int editorRowMatchSpans(Erow *row, int **spans);
+void editorSearchStop(void);
+void editorMatchesUpdate(int from, int to);
+void editorFindPoll(void);
+void editorFindClear(void);
+void editorFindSet(const char *query);
+void editorFindStep(int direction);
+
+#endif
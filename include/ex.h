@@ -0,0 +1,62 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OCEAN_EX_H
+#define OCEAN_EX_H
+
+#include <stddef.h>
+
+/*
+ * A parsed ex command line: an optional range of rows, counted from 0,
+ * and the command to run over it. The cursor row stands in for `.`;
+ * `$` is kept as EX_LAST, since where a file that is still being indexed
+ * ends is not known until the index is finished.
+ */
+#define EX_LAST -1
+
+enum ExType
+{
+    EX_GOTO,
+    EX_WRITE,
+    EX_QUIT,
+    EX_WRITE_QUIT,
+    EX_SUBSTITUTE,
+    EX_GLOBAL,
+    EX_STATS
+};
+
+typedef struct
+{
+    int type;
+    int from;
+    int to;
+    int force;
+    int global;
+    int invert;
+    char *arg;
+    char *pattern;
+    size_t pattern_len;
+    char *replace;
+    size_t replace_len;
+} ExCommand;
+
+const char *exParse(const char *line, int cur, ExCommand *cmd);
+void exFree(ExCommand *cmd);
+
+#endif
@@ -0,0 +1,34 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OCEAN_KEYS_H
+#define OCEAN_KEYS_H
+
+#include <ncurses.h>
+
+/*
+ * Key codes of the curses front end beyond those curses defines: the
+ * markers around a bracketed paste, which init() registers with
+ * define_key and the replay decoder produces from a key log.
+ */
+#define KEY_PASTE (KEY_MAX + 1)
+#define KEY_PASTE_END (KEY_MAX + 2)
+
+#endif
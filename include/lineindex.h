@@ -0,0 +1,56 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OCEAN_LINEINDEX_H
+#define OCEAN_LINEINDEX_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+/*
+ * Line start offsets into a block of raw file bytes, filled in by a
+ * background thread. Offsets live in fixed-size chunks that never move,
+ * so the editor can read every published line while the scan continues.
+ * Each publication is signalled, for readers that wait on a given line.
+ */
+#define LINEINDEX_CHUNK 65536
+
+typedef struct
+{
+    const char *data;
+    size_t size;
+    size_t **chunks;
+    int nchunks;
+    int count;
+    int done;
+    int cancel;
+    int running;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t grown;
+} LineIndex;
+
+void lineIndexStart(LineIndex *idx, const char *data, size_t size);
+int lineIndexLines(LineIndex *idx, int *done);
+void lineIndexLine(LineIndex *idx, int line, const char **start, size_t *len);
+void lineIndexWait(LineIndex *idx);
+void lineIndexWaitLines(LineIndex *idx, int lines);
+void lineIndexFree(LineIndex *idx);
+
+#endif
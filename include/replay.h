@@ -0,0 +1,60 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OCEAN_REPLAY_H
+#define OCEAN_REPLAY_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Plays a recorded keystroke stream back into the editor and times every
+ * key from the moment it is read until the screen has been redrawn. The
+ * log holds the bytes a terminal sends, so a session captured with
+ * `script` or `cat > keys.log` replays as typed; the escape sequences of
+ * the arrow and editing keys and the bracketed paste markers are decoded
+ * into curses key codes. A key read before the one ahead of it was
+ * drawn, as the k of jk is, ends that key's sample where it stands.
+ */
+#define REPLAY_MODES 3
+#define REPLAY_BUCKETS 24
+
+typedef struct
+{
+    char *keys;
+    size_t len;
+    size_t pos;
+    double *samples;
+    unsigned char *modes;
+    int count;
+    int capacity;
+    double start;
+    int mode;
+    int pending;
+    double began;
+} Replay;
+
+int replayOpen(Replay *replay, const char *path);
+void replayFree(Replay *replay);
+int replayKey(Replay *replay, int mode);
+void replayDrawn(Replay *replay);
+void replayReport(Replay *replay, FILE *out);
+
+#endif
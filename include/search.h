@@ -0,0 +1,185 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OCEAN_SEARCH_H
+#define OCEAN_SEARCH_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "buffer.h"
+#include "dfa.h"
+
+/*
+ * A compiled query, either a literal or a regex. The shift table drives
+ * the Horspool scan used where no vector unit is available and for the
+ * short tails the vector loop cannot cover.
+ */
+typedef struct
+{
+    const char *needle;
+    size_t len;
+    const Regex *regex;
+    int spans;
+    size_t shift[256];
+} SearchPattern;
+
+/* per-thread state for matching a pattern against a row at a time */
+typedef struct
+{
+    const SearchPattern *pattern;
+    RegexMatcher regex;
+    const char *s;
+    int size;
+} SearchMatcher;
+
+/* what :s puts in place of each match; see searchReplaceRow */
+typedef struct
+{
+    const char *text;
+    size_t len;
+    int global;
+} SearchReplace;
+
+/* the new chars of a changed row, at `off` in SearchEdits.text */
+typedef struct
+{
+    int row;
+    int len;
+    size_t off;
+} SearchEdit;
+
+typedef struct
+{
+    SearchEdit *edits;
+    int count;
+    int capacity;
+    char *text;
+    size_t len;
+    size_t cap;
+    size_t old_bytes;
+    int subs;
+} SearchEdits;
+
+/* a match position in chars coordinates */
+typedef struct
+{
+    int row;
+    int col;
+} SearchPos;
+
+void searchCompile(
+    SearchPattern *p,
+    const char *needle,
+    size_t len,
+    const Regex *regex
+);
+const char *searchFirst(const SearchPattern *p, const char *s, size_t n);
+void searchMatcherInit(SearchMatcher *m, const SearchPattern *p);
+void searchMatcherFree(SearchMatcher *m);
+void searchMatcherRow(SearchMatcher *m, const char *s, int size);
+int searchMatch(SearchMatcher *m, int from, int *start, int *end);
+int searchMatchEx(SearchMatcher *m, int from, int skip, int *start, int *end);
+int searchReplaceRow(
+    SearchMatcher *m,
+    const SearchReplace *r,
+    const char *s,
+    int size,
+    int at,
+    SearchEdits *edits
+);
+int searchCountRows(
+    const SearchPattern *p,
+    Buffer *buf,
+    int from,
+    int to,
+    int direction,
+    SearchPos *pos
+);
+
+/*
+ * Worker threads that search a buffer in row-range chunks, setting every
+ * row's match count on the way. Chunks are listed in the order a match
+ * should be preferred, so the answer is the first chunk holding one; it
+ * is known as soon as that chunk and every chunk before it are finished,
+ * while the later chunks are still being counted. The same chunks and
+ * workers also run :s over a row range, each chunk collecting its own
+ * edits.
+ */
+#define SEARCH_CHUNK_ROWS 65536
+#define SEARCH_THREADS_MAX 16
+
+#define SEARCH_RUNNING 0
+#define SEARCH_FOUND 1
+#define SEARCH_NONE 2
+
+typedef struct
+{
+    int from;
+    int to;
+    int state;
+    SearchPos pos;
+    SearchEdits edits;
+} SearchChunk;
+
+typedef struct
+{
+    Buffer *buf;
+    SearchPattern pattern;
+    const SearchReplace *replace;
+    int direction;
+    SearchChunk *chunks;
+    int nchunks;
+    int next;
+    int finished;
+    int resolved;
+    int cancel;
+    int running;
+    int generation;
+    int active;
+    int quit;
+    int nthreads;
+    pthread_t threads[SEARCH_THREADS_MAX];
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+} SearchPool;
+
+void searchPoolInit(SearchPool *pool);
+void searchPoolStart(
+    SearchPool *pool,
+    Buffer *buf,
+    const SearchPattern *pattern,
+    int from,
+    int direction
+);
+int searchPoolPoll(SearchPool *pool, SearchPos *pos);
+int searchPoolDone(SearchPool *pool);
+void searchPoolCancel(SearchPool *pool);
+void searchPoolReplace(
+    SearchPool *pool,
+    Buffer *buf,
+    const SearchPattern *pattern,
+    const SearchReplace *replace,
+    int from,
+    int to,
+    SearchEdits *out
+);
+
+#endif
@@ -0,0 +1,59 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OCEAN_SLAB_H
+#define OCEAN_SLAB_H
+
+#include <stddef.h>
+
+/*
+ * Memory for the chars, render and hl of rows. Blocks come in power of
+ * two size classes and the class follows from the bytes a block holds,
+ * so rows need no capacity field: growing a row within its class costs
+ * nothing, and crossing into the next doubles it. Classes up to SLAB_MAX
+ * are cut from SLAB_SIZE slabs, and a freed block goes on a free list to
+ * serve the next request of its class; larger blocks come from malloc.
+ * Slabs are only given back all at once, when the allocator is freed.
+ * `allocs` counts the blocks handed out and `live` the bytes they hold.
+ */
+#define SLAB_MIN 16
+#define SLAB_MAX 4096
+#define SLAB_CLASSES 9
+#define SLAB_SIZE (1024 * 1024)
+
+typedef struct
+{
+    char *free[SLAB_CLASSES];
+    char *top;
+    size_t left;
+    char **slabs;
+    int nslabs;
+    int capacity;
+    unsigned long allocs;
+    size_t live;
+} Slab;
+
+void slabInit(Slab *slab);
+void slabFree(Slab *slab);
+char *slabAlloc(Slab *slab, size_t size);
+char *slabResize(Slab *slab, char *p, size_t old, size_t size);
+void slabRelease(Slab *slab, char *p, size_t size);
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OCEAN_STATS_H
+#define OCEAN_STATS_H
+
+/*
+ * Call counts and time spent for the hot paths of the editor, kept in
+ * one global table that is always compiled in. A timed call reads the
+ * monotonic clock twice, which is cheap next to any of the work timed.
+ */
+enum StatId
+{
+    STAT_UPDATE_ROW,
+    STAT_INSERT_ROWS,
+    STAT_DEL_ROWS,
+    STAT_OPEN,
+    STAT_SAVE,
+    STAT_FIND,
+    STAT_DRAW_ROWS,
+    STAT_FRAME,
+    STATS
+};
+
+typedef struct
+{
+    const char *name;
+    unsigned long calls;
+    double ms;
+    double max;
+} Stat;
+
+extern Stat stats[STATS];
+
+double statsNow(void);
+void statsAdd(int id, double start);
+void statsSort(double *samples, int n);
+double statsPercentile(const double *sorted, int n, int pct);
+
+#endif
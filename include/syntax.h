@@ -0,0 +1,63 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OCEAN_SYNTAX_H
+#define OCEAN_SYNTAX_H
+
+enum EditorHiglightType
+{
+    HL_NORMAL,
+    HL_MATCH,
+    HL_COMMENT,
+    HL_MLCOMMENT,
+    HL_KEYWORD1,
+    HL_KEYWORD2,
+    HL_STRING,
+    HL_NUMBER,
+    HL_SELECT = 1 << 7
+};
+
+#define HL_HIGHLIGHT_NUMBERS (1 << 0)
+#define HL_HIGHLIGHT_STRINGS (1 << 1)
+
+/* state carried from the end of one row into the next */
+#define HL_STATE_NORMAL 0
+#define HL_STATE_COMMENT 1
+
+typedef struct
+{
+    const char *filetype;
+    const char **filematch;
+    const char **keywords;
+    const char *singleline_comment_start;
+    const char *multiline_comment_start;
+    const char *multiline_comment_end;
+    int flags;
+} EditorSyntax;
+
+const EditorSyntax *syntaxSelect(const char *filename);
+int syntaxHighlight(
+    const EditorSyntax *syntax,
+    const char *s,
+    int size,
+    int state,
+    unsigned char *hl
+);
+
+#endif
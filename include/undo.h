@@ -0,0 +1,92 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OCEAN_UNDO_H
+#define OCEAN_UNDO_H
+
+#include <stddef.h>
+
+/*
+ * An undo log of edits, each stored as the operation that was applied
+ * together with the bytes it inserted or removed, so it can be undone
+ * and redone. Ops live in one array and their bytes in an append-only
+ * arena of chunks. Edits made by one command share a group, which undo
+ * and redo apply as a whole; a multi-row op covers any number of rows.
+ * The oldest groups are dropped when the log outgrows its limit.
+ */
+#define UNDO_CHUNK (64 * 1024)
+#define UNDO_LIMIT (64 * 1024 * 1024)
+
+/* every type is paired with its inverse, which differs in the low bit */
+enum UndoType
+{
+    UNDO_INSERT_TEXT,
+    UNDO_DELETE_TEXT,
+    UNDO_SPLIT_ROW,
+    UNDO_JOIN_ROW,
+    UNDO_INSERT_ROWS,
+    UNDO_DELETE_ROWS,
+    UNDO_REPLACE_ROWS,
+    UNDO_RESTORE_ROWS
+};
+
+typedef struct
+{
+    int type;
+    int at;
+    int col;
+    int n;
+    size_t len;
+    char *text;
+    int chunk;
+    int cx;
+    int cy;
+    unsigned long group;
+} UndoOp;
+
+typedef struct
+{
+    UndoOp *ops;
+    int head;
+    int done;
+    int count;
+    int capacity;
+    char **chunks;
+    size_t *used;
+    size_t *sizes;
+    int base;
+    int nchunks;
+    int chunk_capacity;
+    size_t bytes;
+    size_t limit;
+    unsigned long group;
+    int open;
+    int cx;
+    int cy;
+    int replaying;
+} UndoLog;
+
+void undoInit(UndoLog *log, size_t limit);
+void undoFree(UndoLog *log);
+void undoBegin(UndoLog *log, int cx, int cy);
+char *undoPush(UndoLog *log, int type, int at, int col, int n, size_t len);
+int undoStep(UndoLog *log, int direction, UndoOp **ops);
+
+#endif
@@ -0,0 +1,900 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFFER_MAX_DEPTH 16
+
+typedef struct
+{
+    int depth;
+    BufferInner *node[BUFFER_MAX_DEPTH];
+    int slot[BUFFER_MAX_DEPTH];
+} BufferPath;
+
+static BufferLeaf *bufferNewLeaf(void)
+{
+    BufferLeaf *leaf = malloc(sizeof(BufferLeaf));
+    leaf->node.leaf = 1;
+    leaf->node.count = 0;
+    leaf->node.lines = 0;
+    leaf->node.matches = 0;
+    leaf->prev = NULL;
+    leaf->next = NULL;
+    return leaf;
+}
+
+static BufferInner *bufferNewInner(void)
+{
+    BufferInner *inner = malloc(sizeof(BufferInner));
+    inner->node.leaf = 0;
+    inner->node.count = 0;
+    inner->node.lines = 0;
+    inner->node.matches = 0;
+    return inner;
+}
+
+static void bufferRecount(BufferInner *inner)
+{
+    int i;
+    inner->node.lines = 0;
+    inner->node.matches = 0;
+    for (i = 0; i < inner->node.count; i++)
+    {
+        inner->node.lines += inner->child[i]->lines;
+        inner->node.matches += inner->child[i]->matches;
+    }
+}
+
+static int bufferSumRows(const Erow *rows, int n)
+{
+    int sum = 0;
+    int i;
+    for (i = 0; i < n; i++)
+    {
+        sum += rows[i].matches;
+    }
+    return sum;
+}
+
+/* Points the renders of rows just moved to `rows` back at them. */
+static void bufferAdopt(Erow *rows, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+    {
+        if (rows[i].render && rows[i].render->row)
+        {
+            rows[i].render->row = &rows[i];
+        }
+    }
+}
+
+/* Recounts a leaf whose rows have moved, and re-homes their renders. */
+static void bufferRecountLeaf(BufferLeaf *leaf)
+{
+    leaf->node.lines = leaf->node.count;
+    leaf->node.matches = bufferSumRows(leaf->rows, leaf->node.count);
+    bufferAdopt(leaf->rows, leaf->node.count);
+}
+
+static void bufferFreeNode(BufferNode *node)
+{
+    if (!node->leaf)
+    {
+        BufferInner *inner = (BufferInner *)node;
+        int i;
+        for (i = 0; i < inner->node.count; i++)
+        {
+            bufferFreeNode(inner->child[i]);
+        }
+    }
+    free(node);
+}
+
+void bufferInit(Buffer *buf)
+{
+    buf->root = &bufferNewLeaf()->node;
+    buf->numrows = 0;
+}
+
+void bufferFree(Buffer *buf)
+{
+    bufferFreeNode(buf->root);
+    buf->root = NULL;
+    buf->numrows = 0;
+}
+
+/*
+ * Walks from the root to the leaf holding row `at`, recording the inner
+ * nodes passed on the way. Positions on a boundary between two children
+ * resolve to the start of the right one, except at the very end of the
+ * buffer where the last leaf is returned so that appends have a target.
+ */
+static BufferLeaf *bufferDescend(
+    Buffer *buf,
+    int at,
+    BufferPath *path,
+    int *idx
+)
+{
+    BufferNode *node = buf->root;
+    path->depth = 0;
+    while (!node->leaf)
+    {
+        BufferInner *inner = (BufferInner *)node;
+        int i;
+        for (i = 0; i < inner->node.count - 1; i++)
+        {
+            if (at < inner->child[i]->lines)
+            {
+                break;
+            }
+            at -= inner->child[i]->lines;
+        }
+        path->node[path->depth] = inner;
+        path->slot[path->depth] = i;
+        path->depth++;
+        node = inner->child[i];
+    }
+    *idx = at;
+    return (BufferLeaf *)node;
+}
+
+static void bufferPathAdjust(BufferPath *path, int delta, int matches)
+{
+    int d;
+    for (d = 0; d < path->depth; d++)
+    {
+        path->node[d]->node.lines += delta;
+        path->node[d]->node.matches += matches;
+    }
+}
+
+/* Moves everything from `mid` onwards into a fresh right sibling. */
+static BufferNode *bufferSplitNode(BufferNode *node, int mid)
+{
+    if (node->leaf)
+    {
+        BufferLeaf *left = (BufferLeaf *)node;
+        BufferLeaf *right = bufferNewLeaf();
+        right->node.count = left->node.count - mid;
+        memcpy(right->rows, &left->rows[mid], sizeof(Erow) * right->node.count);
+        left->node.count = mid;
+        bufferRecountLeaf(left);
+        bufferRecountLeaf(right);
+        right->next = left->next;
+        right->prev = left;
+        if (left->next)
+        {
+            left->next->prev = right;
+        }
+        left->next = right;
+        return &right->node;
+    }
+    else
+    {
+        BufferInner *left = (BufferInner *)node;
+        BufferInner *right = bufferNewInner();
+        right->node.count = left->node.count - mid;
+        memcpy(
+            right->child,
+            &left->child[mid],
+            sizeof(BufferNode *) * right->node.count
+        );
+        left->node.count = mid;
+        bufferRecount(left);
+        bufferRecount(right);
+        return &right->node;
+    }
+}
+
+/*
+ * Links `right`, freshly split off `left`, into the parent of the node at
+ * depth `d` of `path`, splitting ancestors as needed. Subtree totals above
+ * the split are unchanged since rows only moved between siblings.
+ */
+static void bufferLinkSibling(
+    Buffer *buf,
+    BufferPath *path,
+    int d,
+    BufferNode *left,
+    BufferNode *right
+)
+{
+    BufferInner *parent;
+    int slot;
+
+    if (d == 0)
+    {
+        BufferInner *root = bufferNewInner();
+        root->child[0] = left;
+        root->child[1] = right;
+        root->node.count = 2;
+        bufferRecount(root);
+        buf->root = &root->node;
+        return;
+    }
+
+    parent = path->node[d - 1];
+    slot = path->slot[d - 1];
+    if (parent->node.count == BUFFER_FANOUT)
+    {
+        BufferInner *pright =
+            (BufferInner *)bufferSplitNode(&parent->node, BUFFER_FANOUT / 2);
+        BufferInner *target = parent;
+        if (slot >= BUFFER_FANOUT / 2)
+        {
+            target = pright;
+            slot -= BUFFER_FANOUT / 2;
+        }
+        memmove(
+            &target->child[slot + 2],
+            &target->child[slot + 1],
+            sizeof(BufferNode *) * (target->node.count - slot - 1)
+        );
+        target->child[slot + 1] = right;
+        target->node.count++;
+        bufferRecount(parent);
+        bufferRecount(pright);
+        bufferLinkSibling(buf, path, d - 1, &parent->node, &pright->node);
+        return;
+    }
+
+    memmove(
+        &parent->child[slot + 2],
+        &parent->child[slot + 1],
+        sizeof(BufferNode *) * (parent->node.count - slot - 1)
+    );
+    parent->child[slot + 1] = right;
+    parent->node.count++;
+}
+
+void bufferInsert(Buffer *buf, int at, const Erow *rows, int n)
+{
+    if (at < 0 || at > buf->numrows)
+    {
+        return;
+    }
+
+    while (n > 0)
+    {
+        BufferPath path;
+        int idx;
+        int room;
+        int k;
+        int matches;
+        BufferLeaf *leaf = bufferDescend(buf, at, &path, &idx);
+
+        room = BUFFER_LEAF_ROWS - leaf->node.count;
+        if (room == 0)
+        {
+            /* keep leaves dense for the common append and prepend cases */
+            int mid = BUFFER_LEAF_ROWS / 2;
+            if (idx == leaf->node.count)
+            {
+                mid = leaf->node.count - 1;
+            }
+            else if (idx == 0)
+            {
+                mid = 1;
+            }
+            bufferLinkSibling(
+                buf,
+                &path,
+                path.depth,
+                &leaf->node,
+                bufferSplitNode(&leaf->node, mid)
+            );
+            continue;
+        }
+
+        k = n < room ? n : room;
+        memmove(
+            &leaf->rows[idx + k],
+            &leaf->rows[idx],
+            sizeof(Erow) * (leaf->node.count - idx)
+        );
+        memcpy(&leaf->rows[idx], rows, sizeof(Erow) * k);
+        matches = bufferSumRows(rows, k);
+        leaf->node.count += k;
+        bufferAdopt(&leaf->rows[idx], leaf->node.count - idx);
+        leaf->node.lines += k;
+        leaf->node.matches += matches;
+        bufferPathAdjust(&path, k, matches);
+        buf->numrows += k;
+
+        rows += k;
+        at += k;
+        n -= k;
+    }
+}
+
+static void bufferMerge(BufferNode *left, BufferNode *right)
+{
+    if (left->leaf)
+    {
+        BufferLeaf *l = (BufferLeaf *)left;
+        BufferLeaf *r = (BufferLeaf *)right;
+        memcpy(&l->rows[l->node.count], r->rows, sizeof(Erow) * r->node.count);
+        l->node.count += r->node.count;
+        bufferRecountLeaf(l);
+        l->next = r->next;
+        if (r->next)
+        {
+            r->next->prev = l;
+        }
+    }
+    else
+    {
+        BufferInner *l = (BufferInner *)left;
+        BufferInner *r = (BufferInner *)right;
+        memcpy(
+            &l->child[l->node.count],
+            r->child,
+            sizeof(BufferNode *) * r->node.count
+        );
+        l->node.count += r->node.count;
+        bufferRecount(l);
+    }
+    free(right);
+}
+
+/* Evens out two siblings whose combined contents do not fit in one. */
+static void bufferShare(BufferNode *left, BufferNode *right)
+{
+    int total = left->count + right->count;
+    int want = total / 2;
+
+    if (left->leaf)
+    {
+        BufferLeaf *l = (BufferLeaf *)left;
+        BufferLeaf *r = (BufferLeaf *)right;
+        if (l->node.count > want)
+        {
+            int k = l->node.count - want;
+            memmove(&r->rows[k], r->rows, sizeof(Erow) * r->node.count);
+            memcpy(r->rows, &l->rows[want], sizeof(Erow) * k);
+        }
+        else
+        {
+            int k = want - l->node.count;
+            memcpy(&l->rows[l->node.count], r->rows, sizeof(Erow) * k);
+            memmove(r->rows, &r->rows[k], sizeof(Erow) * (r->node.count - k));
+        }
+        l->node.count = want;
+        r->node.count = total - want;
+        bufferRecountLeaf(l);
+        bufferRecountLeaf(r);
+    }
+    else
+    {
+        BufferInner *l = (BufferInner *)left;
+        BufferInner *r = (BufferInner *)right;
+        if (l->node.count > want)
+        {
+            int k = l->node.count - want;
+            memmove(
+                &r->child[k],
+                r->child,
+                sizeof(BufferNode *) * r->node.count
+            );
+            memcpy(r->child, &l->child[want], sizeof(BufferNode *) * k);
+        }
+        else
+        {
+            int k = want - l->node.count;
+            memcpy(
+                &l->child[l->node.count],
+                r->child,
+                sizeof(BufferNode *) * k
+            );
+            memmove(
+                r->child,
+                &r->child[k],
+                sizeof(BufferNode *) * (r->node.count - k)
+            );
+        }
+        l->node.count = want;
+        r->node.count = total - want;
+        bufferRecount(l);
+        bufferRecount(r);
+    }
+}
+
+/*
+ * Restores the minimum fill of the node at depth `d` after a delete by
+ * merging with or borrowing from a sibling, and collapses a root that is
+ * left with a single child.
+ */
+static void bufferRebalance(Buffer *buf, BufferPath *path, int d)
+{
+    BufferNode *node;
+    BufferInner *parent;
+    BufferNode *left;
+    BufferNode *right;
+    int slot;
+    int max;
+
+    if (d == 0)
+    {
+        while (!buf->root->leaf && buf->root->count == 1)
+        {
+            BufferInner *root = (BufferInner *)buf->root;
+            buf->root = root->child[0];
+            free(root);
+        }
+        return;
+    }
+
+    parent = path->node[d - 1];
+    slot = path->slot[d - 1];
+    node = parent->child[slot];
+    max = node->leaf ? BUFFER_LEAF_ROWS : BUFFER_FANOUT;
+    if (node->count >= max / 4)
+    {
+        return;
+    }
+    if (parent->node.count == 1)
+    {
+        bufferRebalance(buf, path, d - 1);
+        return;
+    }
+
+    if (slot + 1 < parent->node.count)
+    {
+        left = node;
+        right = parent->child[slot + 1];
+    }
+    else
+    {
+        slot--;
+        left = parent->child[slot];
+        right = node;
+    }
+
+    if (left->count + right->count <= max)
+    {
+        bufferMerge(left, right);
+        memmove(
+            &parent->child[slot + 1],
+            &parent->child[slot + 2],
+            sizeof(BufferNode *) * (parent->node.count - slot - 2)
+        );
+        parent->node.count--;
+        bufferRebalance(buf, path, d - 1);
+    }
+    else
+    {
+        bufferShare(left, right);
+    }
+}
+
+void bufferDelete(Buffer *buf, int at, int n)
+{
+    if (at < 0 || at >= buf->numrows)
+    {
+        return;
+    }
+    if (n > buf->numrows - at)
+    {
+        n = buf->numrows - at;
+    }
+
+    while (n > 0)
+    {
+        BufferPath path;
+        int idx;
+        int k;
+        int matches;
+        BufferLeaf *leaf = bufferDescend(buf, at, &path, &idx);
+
+        k = leaf->node.count - idx;
+        if (k > n)
+        {
+            k = n;
+        }
+        matches = bufferSumRows(&leaf->rows[idx], k);
+        memmove(
+            &leaf->rows[idx],
+            &leaf->rows[idx + k],
+            sizeof(Erow) * (leaf->node.count - idx - k)
+        );
+        leaf->node.count -= k;
+        leaf->node.lines -= k;
+        leaf->node.matches -= matches;
+        bufferAdopt(&leaf->rows[idx], leaf->node.count - idx);
+        bufferPathAdjust(&path, -k, -matches);
+        buf->numrows -= k;
+        n -= k;
+
+        bufferRebalance(buf, &path, path.depth);
+    }
+}
+
+/* Frees the inner nodes of a subtree, leaving its leaves alone. */
+static void bufferFreeInner(BufferNode *node)
+{
+    BufferInner *inner = (BufferInner *)node;
+    int i;
+
+    if (node->leaf)
+    {
+        return;
+    }
+    for (i = 0; i < inner->node.count; i++)
+    {
+        bufferFreeInner(inner->child[i]);
+    }
+    free(node);
+}
+
+/*
+ * Evens out a leaf left short by a filter with a neighbour and returns
+ * whichever of the two is still there.
+ */
+static BufferLeaf *bufferMend(BufferLeaf *leaf)
+{
+    BufferLeaf *left;
+    BufferLeaf *right;
+
+    if (leaf->node.count >= BUFFER_LEAF_ROWS / 4 ||
+        (!leaf->next && !leaf->prev))
+    {
+        return leaf;
+    }
+    left = leaf->next ? leaf : leaf->prev;
+    right = left->next;
+    if (left->node.count + right->node.count <= BUFFER_LEAF_ROWS)
+    {
+        bufferMerge(&left->node, &right->node);
+    }
+    else
+    {
+        bufferShare(&left->node, &right->node);
+    }
+    return left;
+}
+
+/*
+ * Deletes the rows among from..from + n - 1 whose entry in `drop` is set.
+ * The survivors are packed down through the leaves in one pass and the
+ * inner levels are rebuilt over the leaf list afterwards, so however many
+ * rows go and however scattered they are, the cost is linear rather than
+ * a tree delete per run. The caller has released the dropped rows.
+ */
+void bufferFilter(Buffer *buf, int from, int n, const unsigned char *drop)
+{
+    BufferPath path;
+    BufferLeaf *rleaf;
+    BufferLeaf *wleaf;
+    BufferLeaf *leaf;
+    BufferNode **level;
+    int ridx;
+    int widx;
+    int removed = 0;
+    int nodes;
+    int i;
+
+    if (from < 0 || from >= buf->numrows || n <= 0)
+    {
+        return;
+    }
+    if (n > buf->numrows - from)
+    {
+        n = buf->numrows - from;
+    }
+    /* rows kept at either end of the range need not move */
+    while (n > 0 && !drop[n - 1])
+    {
+        n--;
+    }
+    if (n == 0)
+    {
+        return;
+    }
+    i = 0;
+    while (!drop[i])
+    {
+        i++;
+    }
+    from += i;
+    drop += i;
+    n -= i;
+
+    /* the write position never overtakes the read position */
+    rleaf = bufferDescend(buf, from, &path, &ridx);
+    wleaf = rleaf;
+    widx = ridx;
+    for (i = 0; i < n; i++)
+    {
+        while (ridx == rleaf->node.count)
+        {
+            rleaf = rleaf->next;
+            ridx = 0;
+        }
+        if (drop[i])
+        {
+            ridx++;
+            removed++;
+            continue;
+        }
+        if (widx == BUFFER_LEAF_ROWS)
+        {
+            wleaf->node.count = widx;
+            bufferRecountLeaf(wleaf);
+            wleaf = wleaf->next;
+            widx = 0;
+        }
+        wleaf->rows[widx++] = rleaf->rows[ridx++];
+    }
+    bufferFreeInner(buf->root);
+
+    /* close the gap before the rows that follow the range */
+    if (wleaf == rleaf)
+    {
+        memmove(
+            &wleaf->rows[widx],
+            &wleaf->rows[ridx],
+            sizeof(Erow) * (wleaf->node.count - ridx)
+        );
+        wleaf->node.count = widx + wleaf->node.count - ridx;
+    }
+    else
+    {
+        leaf = wleaf->next;
+        while (leaf != rleaf)
+        {
+            BufferLeaf *next = leaf->next;
+            free(leaf);
+            leaf = next;
+        }
+        wleaf->next = rleaf;
+        rleaf->prev = wleaf;
+        wleaf->node.count = widx;
+        memmove(
+            rleaf->rows,
+            &rleaf->rows[ridx],
+            sizeof(Erow) * (rleaf->node.count - ridx)
+        );
+        rleaf->node.count -= ridx;
+        bufferRecountLeaf(rleaf);
+    }
+    bufferRecountLeaf(wleaf);
+    if (rleaf != wleaf)
+    {
+        bufferMend(rleaf);
+    }
+    leaf = bufferMend(wleaf);
+    while (leaf->prev)
+    {
+        leaf = leaf->prev;
+    }
+    nodes = 0;
+    for (wleaf = leaf; wleaf; wleaf = wleaf->next)
+    {
+        nodes++;
+    }
+    level = malloc(sizeof(BufferNode *) * nodes);
+    for (i = 0; leaf; leaf = leaf->next)
+    {
+        level[i++] = &leaf->node;
+    }
+
+    /* parents split their children evenly so none is left underfull */
+    while (nodes > 1)
+    {
+        int groups = (nodes + BUFFER_FANOUT - 1) / BUFFER_FANOUT;
+        int g;
+        i = 0;
+        for (g = 0; g < groups; g++)
+        {
+            BufferInner *inner = bufferNewInner();
+            int k = (nodes - i) / (groups - g);
+            memcpy(inner->child, &level[i], sizeof(BufferNode *) * k);
+            inner->node.count = k;
+            bufferRecount(inner);
+            level[g] = &inner->node;
+            i += k;
+        }
+        nodes = groups;
+    }
+    buf->root = level[0];
+    buf->numrows -= removed;
+    free(level);
+}
+
+Erow *bufferGet(Buffer *buf, int at)
+{
+    BufferPath path;
+    BufferLeaf *leaf;
+    int idx;
+
+    if (at < 0 || at >= buf->numrows)
+    {
+        return NULL;
+    }
+    leaf = bufferDescend(buf, at, &path, &idx);
+    return &leaf->rows[idx];
+}
+
+void bufferSetMatches(Buffer *buf, int at, int matches)
+{
+    BufferPath path;
+    BufferLeaf *leaf;
+    int idx;
+    int delta;
+
+    if (at < 0 || at >= buf->numrows)
+    {
+        return;
+    }
+    leaf = bufferDescend(buf, at, &path, &idx);
+    delta = matches - leaf->rows[idx].matches;
+    leaf->rows[idx].matches = matches;
+    leaf->node.matches += delta;
+    bufferPathAdjust(&path, 0, delta);
+}
+
+static void bufferSumNode(BufferNode *node)
+{
+    if (node->leaf)
+    {
+        bufferRecountLeaf((BufferLeaf *)node);
+    }
+    else
+    {
+        BufferInner *inner = (BufferInner *)node;
+        int i;
+        for (i = 0; i < inner->node.count; i++)
+        {
+            bufferSumNode(inner->child[i]);
+        }
+        bufferRecount(inner);
+    }
+}
+
+/* Rebuilds every subtree total after rows' match counts were set directly. */
+void bufferSumMatches(Buffer *buf)
+{
+    bufferSumNode(buf->root);
+}
+
+/* Number of matches in the rows before row `at`. */
+int bufferMatchRank(Buffer *buf, int at)
+{
+    BufferPath path;
+    BufferLeaf *leaf;
+    int idx;
+    int rank;
+    int d;
+
+    if (at <= 0)
+    {
+        return 0;
+    }
+    if (at >= buf->numrows)
+    {
+        return buf->root->matches;
+    }
+    leaf = bufferDescend(buf, at, &path, &idx);
+    rank = bufferSumRows(leaf->rows, idx);
+    for (d = 0; d < path.depth; d++)
+    {
+        int i;
+        for (i = 0; i < path.slot[d]; i++)
+        {
+            rank += path.node[d]->child[i]->matches;
+        }
+    }
+    return rank;
+}
+
+/*
+ * Row holding match `k`, counting from 0 over the whole buffer, with the
+ * match's index within that row stored in `nth`. Returns -1 if there are
+ * not that many matches.
+ */
+int bufferMatchSelect(Buffer *buf, int k, int *nth)
+{
+    BufferNode *node = buf->root;
+    BufferLeaf *leaf;
+    int at = 0;
+    int i;
+
+    if (k < 0 || k >= node->matches)
+    {
+        return -1;
+    }
+    while (!node->leaf)
+    {
+        BufferInner *inner = (BufferInner *)node;
+        for (i = 0; i < inner->node.count - 1; i++)
+        {
+            if (k < inner->child[i]->matches)
+            {
+                break;
+            }
+            k -= inner->child[i]->matches;
+            at += inner->child[i]->lines;
+        }
+        node = inner->child[i];
+    }
+    leaf = (BufferLeaf *)node;
+    for (i = 0; i < leaf->node.count - 1; i++)
+    {
+        if (k < leaf->rows[i].matches)
+        {
+            break;
+        }
+        k -= leaf->rows[i].matches;
+    }
+    *nth = k;
+    return at + i;
+}
+
+/*
+ * Positions `it` just before row `at`: bufferIterNext then yields rows
+ * at, at + 1, ... and bufferIterPrev yields at - 1, at - 2, ...
+ */
+void bufferIterInit(Buffer *buf, BufferIter *it, int at)
+{
+    BufferPath path;
+
+    if (at < 0)
+    {
+        at = 0;
+    }
+    if (at > buf->numrows)
+    {
+        at = buf->numrows;
+    }
+    it->leaf = bufferDescend(buf, at, &path, &it->idx);
+}
+
+Erow *bufferIterNext(BufferIter *it)
+{
+    while (it->idx >= it->leaf->node.count)
+    {
+        if (!it->leaf->next)
+        {
+            return NULL;
+        }
+        it->leaf = it->leaf->next;
+        it->idx = 0;
+    }
+    return &it->leaf->rows[it->idx++];
+}
+
+Erow *bufferIterPrev(BufferIter *it)
+{
+    while (it->idx == 0)
+    {
+        if (!it->leaf->prev)
+        {
+            return NULL;
+        }
+        it->leaf = it->leaf->prev;
+        it->idx = it->leaf->node.count;
+    }
+    return &it->leaf->rows[--it->idx];
+}
@@ -0,0 +1,1201 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dfa.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* input symbols: the 256 byte values and the two ends of a row */
+#define RE_BEGIN 256
+#define RE_END 257
+#define RE_SYMBOLS 258
+
+#define RE_MAX_DEPTH 256
+
+enum ReNodeType
+{
+    RE_EMPTY,
+    RE_SET,
+    RE_BEGIN_NODE,
+    RE_END_NODE,
+    RE_CAT,
+    RE_ALT,
+    RE_STAR,
+    RE_PLUS,
+    RE_QUEST
+};
+
+typedef struct
+{
+    int type;
+    int a;
+    int b;
+    unsigned char set[32];
+} ReNode;
+
+typedef struct
+{
+    const char *s;
+    size_t len;
+    size_t pos;
+    const char *error;
+    ReNode *nodes;
+    int nnodes;
+    int capacity;
+} ReParser;
+
+enum NfaType
+{
+    NFA_SET,
+    NFA_BEGIN,
+    NFA_END,
+    NFA_SPLIT,
+    NFA_ANY,
+    NFA_MATCH
+};
+
+typedef struct
+{
+    int type;
+    int out;
+    int out1;
+    unsigned char set[32];
+} NfaState;
+
+struct Regex
+{
+    NfaState *states;
+    int nstates;
+    int capacity;
+    int forward;
+    int reverse;
+    int anchored;
+    int empty;
+    int *preds;
+    int *pred_start;
+};
+
+static void reSetAdd(unsigned char *set, int c)
+{
+    set[c >> 3] |= 1 << (c & 7);
+}
+
+static int reSetHas(const unsigned char *set, int c)
+{
+    return set[c >> 3] & (1 << (c & 7));
+}
+
+static int reNode(ReParser *p, int type, int a, int b)
+{
+    if (p->nnodes == p->capacity)
+    {
+        p->capacity = p->capacity ? p->capacity * 2 : 32;
+        p->nodes = realloc(p->nodes, sizeof(ReNode) * p->capacity);
+    }
+    p->nodes[p->nnodes].type = type;
+    p->nodes[p->nnodes].a = a;
+    p->nodes[p->nnodes].b = b;
+    memset(p->nodes[p->nnodes].set, 0, 32);
+    return p->nnodes++;
+}
+
+static int reFail(ReParser *p, const char *error)
+{
+    if (!p->error)
+    {
+        p->error = error;
+    }
+    return -1;
+}
+
+/* Adds the class named by escape letter `c` to `set`, if it names one. */
+static int reClassEscape(unsigned char *set, int c)
+{
+    int negate = c == 'D' || c == 'W' || c == 'S';
+    unsigned char class[32];
+    int i;
+
+    memset(class, 0, sizeof(class));
+    switch (c)
+    {
+    case 'd':
+    case 'D':
+        for (i = '0'; i <= '9'; i++)
+        {
+            reSetAdd(class, i);
+        }
+        break;
+    case 'w':
+    case 'W':
+        for (i = 0; i < 256; i++)
+        {
+            if ((i >= 'a' && i <= 'z') || (i >= 'A' && i <= 'Z') ||
+                (i >= '0' && i <= '9') || i == '_')
+            {
+                reSetAdd(class, i);
+            }
+        }
+        break;
+    case 's':
+    case 'S':
+        reSetAdd(class, ' ');
+        reSetAdd(class, '\t');
+        reSetAdd(class, '\r');
+        reSetAdd(class, '\f');
+        reSetAdd(class, '\v');
+        break;
+    default:
+        return 0;
+    }
+    for (i = 0; i < 32; i++)
+    {
+        set[i] |= negate ? ~class[i] : class[i];
+    }
+    return 1;
+}
+
+static int reEscapeChar(int c)
+{
+    switch (c)
+    {
+    case 'n':
+        return '\n';
+    case 't':
+        return '\t';
+    case 'r':
+        return '\r';
+    default:
+        return c;
+    }
+}
+
+static int reParseClass(ReParser *p)
+{
+    int node = reNode(p, RE_SET, -1, -1);
+    unsigned char set[32];
+    int negate = 0;
+    int first = 1;
+    int i;
+
+    memset(set, 0, sizeof(set));
+    if (p->pos < p->len && p->s[p->pos] == '^')
+    {
+        negate = 1;
+        p->pos++;
+    }
+    while (p->pos < p->len && (first || p->s[p->pos] != ']'))
+    {
+        int lo = (unsigned char)p->s[p->pos++];
+        int hi;
+
+        first = 0;
+        if (lo == '\\')
+        {
+            if (p->pos == p->len)
+            {
+                break;
+            }
+            lo = (unsigned char)p->s[p->pos++];
+            if (reClassEscape(set, lo))
+            {
+                continue;
+            }
+            lo = reEscapeChar(lo);
+        }
+        hi = lo;
+        if (p->pos + 1 < p->len && p->s[p->pos] == '-' &&
+            p->s[p->pos + 1] != ']')
+        {
+            hi = (unsigned char)p->s[p->pos + 1];
+            p->pos += 2;
+            if (hi == '\\' && p->pos < p->len)
+            {
+                hi = reEscapeChar((unsigned char)p->s[p->pos++]);
+            }
+            if (hi < lo)
+            {
+                return reFail(p, "bad range");
+            }
+        }
+        for (i = lo; i <= hi; i++)
+        {
+            reSetAdd(set, i);
+        }
+    }
+    if (p->pos == p->len)
+    {
+        return reFail(p, "missing ]");
+    }
+    p->pos++;
+    for (i = 0; i < 32; i++)
+    {
+        p->nodes[node].set[i] = negate ? ~set[i] : set[i];
+    }
+    return node;
+}
+
+static int reParseAlt(ReParser *p, int depth);
+
+static int reParseAtom(ReParser *p, int depth)
+{
+    int c = (unsigned char)p->s[p->pos++];
+    int node;
+    int i;
+
+    switch (c)
+    {
+    case '(':
+        if (depth >= RE_MAX_DEPTH)
+        {
+            return reFail(p, "nested too deeply");
+        }
+        node = reParseAlt(p, depth + 1);
+        if (node < 0)
+        {
+            return -1;
+        }
+        if (p->pos == p->len || p->s[p->pos] != ')')
+        {
+            return reFail(p, "missing )");
+        }
+        p->pos++;
+        return node;
+    case '[':
+        return reParseClass(p);
+    case '*':
+    case '+':
+    case '?':
+        return reFail(p, "nothing to repeat");
+    case '^':
+        return reNode(p, RE_BEGIN_NODE, -1, -1);
+    case '$':
+        return reNode(p, RE_END_NODE, -1, -1);
+    case '.':
+        node = reNode(p, RE_SET, -1, -1);
+        for (i = 0; i < 256; i++)
+        {
+            if (i != '\n')
+            {
+                reSetAdd(p->nodes[node].set, i);
+            }
+        }
+        return node;
+    case '\\':
+        if (p->pos == p->len)
+        {
+            return reFail(p, "trailing \\");
+        }
+        c = (unsigned char)p->s[p->pos++];
+        node = reNode(p, RE_SET, -1, -1);
+        if (!reClassEscape(p->nodes[node].set, c))
+        {
+            reSetAdd(p->nodes[node].set, reEscapeChar(c));
+        }
+        return node;
+    default:
+        node = reNode(p, RE_SET, -1, -1);
+        reSetAdd(p->nodes[node].set, c);
+        return node;
+    }
+}
+
+static int reParseRepeat(ReParser *p, int depth)
+{
+    int node = reParseAtom(p, depth);
+
+    while (node >= 0 && p->pos < p->len)
+    {
+        int c = p->s[p->pos];
+        if (c == '*')
+        {
+            node = reNode(p, RE_STAR, node, -1);
+        }
+        else if (c == '+')
+        {
+            node = reNode(p, RE_PLUS, node, -1);
+        }
+        else if (c == '?')
+        {
+            node = reNode(p, RE_QUEST, node, -1);
+        }
+        else
+        {
+            break;
+        }
+        p->pos++;
+    }
+    return node;
+}
+
+static int reParseCat(ReParser *p, int depth)
+{
+    int node = -1;
+
+    while (p->pos < p->len && p->s[p->pos] != '|' && p->s[p->pos] != ')')
+    {
+        int next = reParseRepeat(p, depth);
+        if (next < 0)
+        {
+            return -1;
+        }
+        node = node < 0 ? next : reNode(p, RE_CAT, node, next);
+    }
+    return node < 0 ? reNode(p, RE_EMPTY, -1, -1) : node;
+}
+
+static int reParseAlt(ReParser *p, int depth)
+{
+    int node = reParseCat(p, depth);
+
+    while (node >= 0 && p->pos < p->len && p->s[p->pos] == '|')
+    {
+        int next;
+        p->pos++;
+        next = reParseCat(p, depth);
+        if (next < 0)
+        {
+            return -1;
+        }
+        node = reNode(p, RE_ALT, node, next);
+    }
+    return node;
+}
+
+static int nfaState(Regex *re, int type, int out, int out1)
+{
+    if (re->nstates == re->capacity)
+    {
+        re->capacity = re->capacity ? re->capacity * 2 : 32;
+        re->states = realloc(re->states, sizeof(NfaState) * re->capacity);
+    }
+    re->states[re->nstates].type = type;
+    re->states[re->nstates].out = out;
+    re->states[re->nstates].out1 = out1;
+    return re->nstates++;
+}
+
+/*
+ * Builds the NFA for `node` in front of state `next` and returns its
+ * entry. With `reverse` set the result matches the reversed strings, so
+ * that a match can be traced backwards from where it ends.
+ */
+static int nfaCompile(Regex *re, ReNode *nodes, int node, int next, int reverse)
+{
+    ReNode *n = &nodes[node];
+    int s;
+
+    switch (n->type)
+    {
+    case RE_SET:
+        s = nfaState(re, NFA_SET, next, -1);
+        memcpy(re->states[s].set, n->set, 32);
+        return s;
+    case RE_BEGIN_NODE:
+        return nfaState(re, NFA_BEGIN, next, -1);
+    case RE_END_NODE:
+        return nfaState(re, NFA_END, next, -1);
+    case RE_CAT:
+        if (reverse)
+        {
+            return nfaCompile(
+                re,
+                nodes,
+                n->b,
+                nfaCompile(re, nodes, n->a, next, reverse),
+                reverse
+            );
+        }
+        return nfaCompile(
+            re,
+            nodes,
+            n->a,
+            nfaCompile(re, nodes, n->b, next, reverse),
+            reverse
+        );
+    case RE_ALT:
+    {
+        int a = nfaCompile(re, nodes, n->a, next, reverse);
+        int b = nfaCompile(re, nodes, n->b, next, reverse);
+        return nfaState(re, NFA_SPLIT, a, b);
+    }
+    case RE_STAR:
+    case RE_PLUS:
+    {
+        int body;
+        s = nfaState(re, NFA_SPLIT, -1, next);
+        body = nfaCompile(re, nodes, n->a, s, reverse);
+        re->states[s].out = body;
+        return n->type == RE_STAR ? s : body;
+    }
+    case RE_QUEST:
+        return nfaState(
+            re,
+            NFA_SPLIT,
+            nfaCompile(re, nodes, n->a, next, reverse),
+            next
+        );
+    default:
+        return next;
+    }
+}
+
+/*
+ * Lists the states with an edge into each state of the unanchored
+ * program, as preds[pred_start[s], pred_start[s + 1]), so that the live
+ * automaton can walk the program backwards.
+ */
+static void nfaLinkPreds(Regex *re)
+{
+    int *seen = calloc(re->nstates, sizeof(int));
+    int *fill = malloc(sizeof(int) * (re->nstates + 1));
+    int n = 0;
+    int i;
+
+    re->pred_start = calloc(re->nstates + 1, sizeof(int));
+    seen[re->forward] = 1;
+    fill[n++] = re->forward;
+    while (n > 0)
+    {
+        const NfaState *st = &re->states[fill[--n]];
+        int out[2];
+        int k;
+
+        out[0] = st->out;
+        out[1] = st->out1;
+        for (k = 0; k < 2; k++)
+        {
+            if (out[k] >= 0)
+            {
+                re->pred_start[out[k] + 1]++;
+                if (!seen[out[k]])
+                {
+                    seen[out[k]] = 1;
+                    fill[n++] = out[k];
+                }
+            }
+        }
+    }
+    for (i = 0; i < re->nstates; i++)
+    {
+        re->pred_start[i + 1] += re->pred_start[i];
+    }
+    re->preds = malloc(sizeof(int) * (re->pred_start[re->nstates] + 1));
+    memcpy(fill, re->pred_start, sizeof(int) * (re->nstates + 1));
+    for (i = 0; i < re->nstates; i++)
+    {
+        const NfaState *st = &re->states[i];
+        if (!seen[i])
+        {
+            continue;
+        }
+        if (st->out >= 0)
+        {
+            re->preds[fill[st->out]++] = i;
+        }
+        if (st->out1 >= 0)
+        {
+            re->preds[fill[st->out1]++] = i;
+        }
+    }
+    free(fill);
+    free(seen);
+}
+
+/* Whether `node` matches the empty string where ^ and $ hold as given. */
+static int reNullable(const ReNode *nodes, int node, int begin, int end)
+{
+    const ReNode *n = &nodes[node];
+
+    switch (n->type)
+    {
+    case RE_SET:
+        return 0;
+    case RE_BEGIN_NODE:
+        return begin;
+    case RE_END_NODE:
+        return end;
+    case RE_CAT:
+        return reNullable(nodes, n->a, begin, end) &&
+               reNullable(nodes, n->b, begin, end);
+    case RE_ALT:
+        return reNullable(nodes, n->a, begin, end) ||
+               reNullable(nodes, n->b, begin, end);
+    case RE_PLUS:
+        return reNullable(nodes, n->a, begin, end);
+    default:
+        return 1;
+    }
+}
+
+Regex *regexCompile(const char *pattern, size_t len, const char **error)
+{
+    ReParser p;
+    Regex *re;
+    int root;
+    int match;
+    int any;
+
+    p.s = pattern;
+    p.len = len;
+    p.pos = 0;
+    p.error = NULL;
+    p.nodes = NULL;
+    p.nnodes = 0;
+    p.capacity = 0;
+    root = reParseAlt(&p, 0);
+    if (root >= 0 && p.pos < p.len)
+    {
+        root = reFail(&p, "unmatched )");
+    }
+    if (root < 0)
+    {
+        *error = p.error;
+        free(p.nodes);
+        return NULL;
+    }
+
+    re = malloc(sizeof(Regex));
+    re->states = NULL;
+    re->nstates = 0;
+    re->capacity = 0;
+    match = nfaState(re, NFA_MATCH, -1, -1);
+    re->anchored = nfaCompile(re, p.nodes, root, match, 0);
+    re->reverse = nfaCompile(re, p.nodes, root, match, 1);
+    /* the unanchored program lets a match begin at any position */
+    any = nfaState(re, NFA_ANY, -1, -1);
+    re->forward = nfaState(re, NFA_SPLIT, re->anchored, any);
+    re->states[any].out = re->forward;
+    nfaLinkPreds(re);
+    re->empty = 0;
+    for (any = 0; any < 4; any++)
+    {
+        if (reNullable(p.nodes, root, any >> 1, any & 1))
+        {
+            re->empty |= 1 << any;
+        }
+    }
+    free(p.nodes);
+    *error = NULL;
+    return re;
+}
+
+void regexFree(Regex *re)
+{
+    if (re)
+    {
+        free(re->states);
+        free(re->preds);
+        free(re->pred_start);
+        free(re);
+    }
+}
+
+/*
+ * DFA states are lists of NFA threads. A thread is an NFA state plus one
+ * bit saying whether it has consumed a byte yet, so that only non-empty
+ * matches are reported; the unconsumed match thread is never kept.
+ * Splits, and anchors for the boundary being fed, are followed eagerly
+ * and never stored.
+ *
+ * A leftmost DFA keeps its threads in priority order, earlier starts and
+ * left alternatives first, and drops everything behind a match, which
+ * gives Perl's leftmost-first semantics. The other mode keeps its lists
+ * sorted so that equal sets share one state, and finds longest matches.
+ */
+static int dfaAdd(Dfa *d, int seed, int sym, int *count)
+{
+    const NfaState *states = d->re->states;
+    int n = 0;
+
+    d->stack[n++] = seed;
+    while (n > 0)
+    {
+        int thread = d->stack[--n];
+        const NfaState *st = &states[thread >> 1];
+        if (d->mark[thread] == d->gen || thread == 0)
+        {
+            continue;
+        }
+        d->mark[thread] = d->gen;
+        if (st->type == NFA_SPLIT)
+        {
+            d->stack[n++] = (st->out1 << 1) | (thread & 1);
+            d->stack[n++] = (st->out << 1) | (thread & 1);
+        }
+        else if ((st->type == NFA_BEGIN && sym == RE_BEGIN) ||
+                 (st->type == NFA_END && sym == RE_END))
+        {
+            d->stack[n++] = (st->out << 1) | (thread & 1);
+        }
+        else
+        {
+            d->scratch[(*count)++] = thread;
+            if (thread == 1 && d->leftmost)
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int dfaCompareInt(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+static unsigned int dfaHash(const int *set, int n)
+{
+    unsigned int h = 2166136261u;
+    int i;
+    for (i = 0; i < n; i++)
+    {
+        h = (h ^ (unsigned int)set[i]) * 16777619u;
+    }
+    return h;
+}
+
+static void dfaFlush(Dfa *d)
+{
+    int i;
+    for (i = 0; i < d->nstates; i++)
+    {
+        free(d->sets[i]);
+    }
+    d->flushes++;
+    d->nstates = 0;
+    d->start = -1;
+    for (i = 0; i < d->table_size; i++)
+    {
+        d->table[i] = -1;
+    }
+}
+
+/* Slot holding the state for thread list `set`, or the empty one. */
+static int dfaSlot(Dfa *d, const int *set, int n, unsigned int h)
+{
+    int mask = d->table_size - 1;
+    int slot = h & mask;
+
+    while (d->table[slot] >= 0)
+    {
+        int id = d->table[slot];
+        if (d->lengths[id] == n && !memcmp(d->sets[id], set, sizeof(int) * n))
+        {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/*
+ * Finds or creates the state for the `n` threads in scratch. When the
+ * cache is full it is emptied first and `flushed` is set, since any
+ * state the caller still holds is gone.
+ */
+static int dfaIntern(Dfa *d, int n, int *flushed)
+{
+    unsigned int h;
+    int slot;
+    int id;
+    int i;
+
+    if (!d->leftmost)
+    {
+        qsort(d->scratch, n, sizeof(int), dfaCompareInt);
+    }
+    h = dfaHash(d->scratch, n);
+    slot = dfaSlot(d, d->scratch, n, h);
+    if (d->table[slot] >= 0)
+    {
+        return d->table[slot];
+    }
+
+    if (d->nstates == DFA_MAX_STATES)
+    {
+        dfaFlush(d);
+        *flushed = 1;
+        slot = dfaSlot(d, d->scratch, n, h);
+    }
+    if (d->nstates == d->capacity)
+    {
+        d->capacity *= 2;
+        d->next = realloc(d->next, sizeof(int) * RE_SYMBOLS * d->capacity);
+        d->accept = realloc(d->accept, d->capacity);
+        d->sets = realloc(d->sets, sizeof(int *) * d->capacity);
+        d->lengths = realloc(d->lengths, sizeof(int) * d->capacity);
+        d->pruned = realloc(d->pruned, sizeof(int) * d->capacity);
+        d->pruned_by = realloc(d->pruned_by, sizeof(int) * d->capacity);
+    }
+
+    id = d->nstates++;
+    d->sets[id] = malloc(sizeof(int) * (n ? n : 1));
+    memcpy(d->sets[id], d->scratch, sizeof(int) * n);
+    d->lengths[id] = n;
+    d->pruned_by[id] = -1;
+    /* thread 1 is the match state having consumed a byte; it sorts first
+     * and is the last thread a leftmost list keeps */
+    d->accept[id] = n > 0 && d->scratch[d->leftmost ? n - 1 : 0] == 1;
+    for (i = 0; i < RE_SYMBOLS; i++)
+    {
+        d->next[id * RE_SYMBOLS + i] = -1;
+    }
+    d->table[slot] = id;
+    return id;
+}
+
+static void dfaInit(Dfa *d, const Regex *re, int entry, int leftmost)
+{
+    int threads = re->nstates * 2;
+    int i;
+
+    d->re = re;
+    d->entry = entry;
+    d->leftmost = leftmost;
+    d->nstates = 0;
+    d->capacity = 16;
+    d->next = malloc(sizeof(int) * RE_SYMBOLS * d->capacity);
+    d->accept = malloc(d->capacity);
+    d->sets = malloc(sizeof(int *) * d->capacity);
+    d->lengths = malloc(sizeof(int) * d->capacity);
+    d->pruned = malloc(sizeof(int) * d->capacity);
+    d->pruned_by = malloc(sizeof(int) * d->capacity);
+    d->flushes = 0;
+    d->table_size = DFA_MAX_STATES * 2;
+    d->table = malloc(sizeof(int) * d->table_size);
+    d->mark = calloc(threads, sizeof(int));
+    d->gen = 0;
+    /* every split pushes two threads, but only once per generation */
+    d->stack = malloc(sizeof(int) * (threads * 2 + 1));
+    d->scratch = malloc(sizeof(int) * threads);
+    d->start = -1;
+    for (i = 0; i < d->table_size; i++)
+    {
+        d->table[i] = -1;
+    }
+}
+
+static void dfaFree(Dfa *d)
+{
+    dfaFlush(d);
+    free(d->next);
+    free(d->accept);
+    free(d->sets);
+    free(d->lengths);
+    free(d->pruned);
+    free(d->pruned_by);
+    free(d->table);
+    free(d->mark);
+    free(d->stack);
+    free(d->scratch);
+}
+
+static int dfaStart(Dfa *d)
+{
+    if (d->start < 0)
+    {
+        int count = 0;
+        int flushed = 0;
+        d->gen++;
+        dfaAdd(d, d->entry << 1, -1, &count);
+        d->start = dfaIntern(d, count, &flushed);
+    }
+    return d->start;
+}
+
+/*
+ * Row boundaries are zero-width: every thread carries over them, and the
+ * ones waiting for that boundary pass it, so they are only fed where a
+ * row actually starts or ends.
+ */
+static int dfaStep(Dfa *d, int id, int sym)
+{
+    const NfaState *states = d->re->states;
+    int *set;
+    int len;
+    int count = 0;
+    int flushed = 0;
+    int next;
+    int i;
+
+    next = d->next[id * RE_SYMBOLS + sym];
+    if (next >= 0)
+    {
+        return next;
+    }
+
+    set = d->sets[id];
+    len = d->lengths[id];
+    d->gen++;
+    for (i = 0; i < len; i++)
+    {
+        int thread = set[i];
+        const NfaState *st = &states[thread >> 1];
+        int target = sym >= 256 ? thread : -1;
+
+        switch (st->type)
+        {
+        case NFA_SET:
+            if (sym < 256 && reSetHas(st->set, sym))
+            {
+                target = (st->out << 1) | 1;
+            }
+            break;
+        case NFA_ANY:
+            if (sym < 256)
+            {
+                target = st->out << 1;
+            }
+            break;
+        }
+        if (target >= 0 && dfaAdd(d, target, sym, &count))
+        {
+            break;
+        }
+    }
+    next = dfaIntern(d, count, &flushed);
+    if (!flushed)
+    {
+        d->next[id * RE_SYMBOLS + sym] = next;
+    }
+    return next;
+}
+
+/*
+ * The live automaton runs backwards along a row over the states of the
+ * unanchored program. Its state at a position lists, sorted, the NFA
+ * states from which a match can still be completed there, which lets a
+ * forward pass drop threads that are sure to die.
+ *
+ * Adds to scratch[0, n), whose states are marked, those with an empty
+ * path into one of them, passing the anchors for boundary `sym`, and
+ * returns the new count.
+ */
+static int dfaLiveClose(Dfa *d, int n, int sym)
+{
+    const Regex *re = d->re;
+    int top = 0;
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        d->stack[top++] = d->scratch[i];
+    }
+    while (top > 0)
+    {
+        int s = d->stack[--top];
+        for (i = re->pred_start[s]; i < re->pred_start[s + 1]; i++)
+        {
+            int q = re->preds[i];
+            int type = re->states[q].type;
+            if (d->mark[q] != d->gen &&
+                (type == NFA_SPLIT || (type == NFA_BEGIN && sym == RE_BEGIN) ||
+                 (type == NFA_END && sym == RE_END)))
+            {
+                d->mark[q] = d->gen;
+                d->scratch[n++] = q;
+                d->stack[top++] = q;
+            }
+        }
+    }
+    return n;
+}
+
+/* the match state, the first one compiled, is live everywhere */
+static int dfaLiveStart(Dfa *d)
+{
+    if (d->start < 0)
+    {
+        int flushed = 0;
+        d->gen++;
+        d->mark[0] = d->gen;
+        d->scratch[0] = 0;
+        d->start = dfaIntern(d, dfaLiveClose(d, 1, -1), &flushed);
+    }
+    return d->start;
+}
+
+/*
+ * Steps back over byte `sym` to the state before it, or passes a row
+ * boundary, which keeps every state and lets its anchors through.
+ */
+static int dfaLiveStep(Dfa *d, int id, int sym)
+{
+    const Regex *re = d->re;
+    int *set;
+    int len;
+    int count = 0;
+    int flushed = 0;
+    int next;
+    int i;
+
+    next = d->next[id * RE_SYMBOLS + sym];
+    if (next >= 0)
+    {
+        return next;
+    }
+
+    set = d->sets[id];
+    len = d->lengths[id];
+    d->gen++;
+    if (sym >= 256)
+    {
+        for (i = 0; i < len; i++)
+        {
+            d->mark[set[i]] = d->gen;
+            d->scratch[count++] = set[i];
+        }
+    }
+    else
+    {
+        d->mark[0] = d->gen;
+        d->scratch[count++] = 0;
+        for (i = 0; i < len; i++)
+        {
+            int k;
+            for (k = re->pred_start[set[i]]; k < re->pred_start[set[i] + 1];
+                 k++)
+            {
+                int q = re->preds[k];
+                const NfaState *st = &re->states[q];
+                if (d->mark[q] != d->gen &&
+                    (st->type == NFA_ANY ||
+                     (st->type == NFA_SET && reSetHas(st->set, sym))))
+                {
+                    d->mark[q] = d->gen;
+                    d->scratch[count++] = q;
+                }
+            }
+        }
+    }
+    next = dfaIntern(d, dfaLiveClose(d, count, sym), &flushed);
+    if (!flushed)
+    {
+        d->next[id * RE_SYMBOLS + sym] = next;
+    }
+    return next;
+}
+
+/*
+ * Forward state `id` without the threads whose NFA state is missing from
+ * live state `live` of automaton `l`. The last result is kept per state,
+ * since the live state tends to stay the same along a row.
+ */
+static int dfaPrune(Dfa *d, int id, const Dfa *l, int live)
+{
+    const int *set;
+    int len;
+    int count = 0;
+    int flushed = 0;
+    int next;
+    int i;
+
+    if (d->pruned_by[id] == live)
+    {
+        return d->pruned[id];
+    }
+    d->gen++;
+    for (i = 0; i < l->lengths[live]; i++)
+    {
+        d->mark[l->sets[live][i] << 1] = d->gen;
+    }
+    set = d->sets[id];
+    len = d->lengths[id];
+    for (i = 0; i < len; i++)
+    {
+        if (d->mark[set[i] & ~1] == d->gen)
+        {
+            d->scratch[count++] = set[i];
+        }
+    }
+    next = dfaIntern(d, count, &flushed);
+    if (!flushed)
+    {
+        d->pruned_by[id] = live;
+        d->pruned[id] = next;
+    }
+    return next;
+}
+
+/*
+ * Whether the regex matches the empty string at a position of a row,
+ * which depends only on whether that is the row's start (`begin`) and
+ * its end (`end`). regexFind never reports empty matches.
+ */
+int regexMatchesEmpty(const Regex *re, int begin, int end)
+{
+    return (re->empty >> ((begin ? 2 : 0) | (end ? 1 : 0))) & 1;
+}
+
+void regexMatcherInit(RegexMatcher *m, const Regex *re)
+{
+    dfaInit(&m->forward, re, re->forward, 1);
+    dfaInit(&m->reverse, re, re->reverse, 0);
+    dfaInit(&m->live, re, re->forward, 0);
+    m->row = NULL;
+    m->size = 0;
+    m->lives = NULL;
+    m->fence = -1;
+    m->capacity = 0;
+}
+
+void regexMatcherFree(RegexMatcher *m)
+{
+    dfaFree(&m->forward);
+    dfaFree(&m->reverse);
+    dfaFree(&m->live);
+    free(m->lives);
+}
+
+/*
+ * Makes s[0, size) the row that regexFind searches, and runs the live
+ * automaton over it once from its end. A flush of the live cache renumbers
+ * its states, so positions behind the last one, past `fence`, go unpruned.
+ */
+void regexMatcherRow(RegexMatcher *m, const char *s, int size)
+{
+    Dfa *d = &m->live;
+    int flushes = d->flushes;
+    int st;
+    int i;
+
+    if (size >= m->capacity)
+    {
+        m->capacity = size * 2 + 1;
+        m->lives = realloc(m->lives, sizeof(int) * m->capacity);
+    }
+    m->row = s;
+    m->size = size;
+    m->fence = size;
+    st = dfaLiveStep(d, dfaLiveStart(d), RE_END);
+    for (i = size; i >= 0; i--)
+    {
+        if (i < size)
+        {
+            st = dfaLiveStep(d, st, (unsigned char)s[i]);
+        }
+        if (i == 0)
+        {
+            st = dfaLiveStep(d, st, RE_BEGIN);
+        }
+        if (d->flushes != flushes)
+        {
+            m->fence = i;
+        }
+        m->lives[i] = st;
+    }
+    /* pruned states are kept by live state number */
+    if (d->flushes != flushes)
+    {
+        for (i = 0; i < m->forward.nstates; i++)
+        {
+            m->forward.pruned_by[i] = -1;
+        }
+    }
+}
+
+/* Forward state `st` at position `at` of the row, pruned where known. */
+static int regexPrune(RegexMatcher *m, int st, int at)
+{
+    if (at > m->fence)
+    {
+        return st;
+    }
+    return dfaPrune(&m->forward, st, &m->live, m->lives[at]);
+}
+
+/*
+ * Finds the leftmost-first match in the matcher's row that starts at or
+ * after `from`. The forward pass drops threads with no match ahead, so
+ * it stops as soon as its state holds only a match, which is where the
+ * match ends, and the reverse pass walks back from there to where it
+ * starts. Neither looks outside [from, end), so walking a row's matches
+ * with each search resuming at the last end reads every byte a bounded
+ * number of times.
+ */
+int regexFind(RegexMatcher *m, int from, int *start, int *end)
+{
+    const char *s = m->row;
+    int size = m->size;
+    Dfa *d = &m->forward;
+    int st = dfaStart(d);
+    int b = -1;
+    int e = -1;
+    int i;
+
+    if (from == 0)
+    {
+        st = dfaStep(d, st, RE_BEGIN);
+    }
+    st = regexPrune(m, st, from);
+    /* a state holding nothing but its match has settled */
+    for (i = from; i < size && d->lengths[st] > d->accept[st]; i++)
+    {
+        st = regexPrune(m, dfaStep(d, st, (unsigned char)s[i]), i + 1);
+        if (d->accept[st])
+        {
+            e = i + 1;
+        }
+    }
+    /* stepping can grow the arrays, so it goes before looking at them */
+    if (i == size && d->lengths[st])
+    {
+        st = dfaStep(d, st, RE_END);
+        if (d->accept[st])
+        {
+            e = size;
+        }
+    }
+    if (e < 0)
+    {
+        return 0;
+    }
+
+    d = &m->reverse;
+    st = dfaStart(d);
+    if (e == size)
+    {
+        st = dfaStep(d, st, RE_END);
+    }
+    for (i = e - 1; i >= from && d->lengths[st]; i--)
+    {
+        st = dfaStep(d, st, (unsigned char)s[i]);
+        if (d->accept[st])
+        {
+            b = i;
+        }
+    }
+    if (i < 0 && d->lengths[st])
+    {
+        st = dfaStep(d, st, RE_BEGIN);
+        if (d->accept[st])
+        {
+            b = 0;
+        }
+    }
+    if (b < 0)
+    {
+        return 0;
+    }
+    *start = b;
+    *end = e;
+    return 1;
+}
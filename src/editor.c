@@ -0,0 +1,2465 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include "editor.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ex.h"
+
+#define LOAD_BATCH 256
+#define SAVE_IOV 1024
+#define RENDER_CACHE_BUDGET (16 * 1024 * 1024)
+
+Editor E;
+
+/* the render of every row without tabs or highlighting */
+static Erender editorPlain = {
+    0,
+    RENDER_SHARED | RENDER_PLAIN,
+    0,
+    NULL,
+    NULL,
+    NULL
+};
+
+void die(const char *s)
+{
+    perror(s);
+    exit(1);
+}
+
+/*
+ * Marks file rows from..to as needing a redraw, with to < 0 meaning down to
+ * the bottom of the screen. Rows are mapped through the offset of the last
+ * frame, which is what is on the terminal right now.
+ */
+void editorDamageRows(int from, int to)
+{
+    int last = E.drawn_rowoff + E.screenrows - 1;
+    if (to < 0 || to > last)
+    {
+        to = last;
+    }
+    if (from < E.drawn_rowoff)
+    {
+        from = E.drawn_rowoff;
+    }
+    for (; from <= to; from++)
+    {
+        E.damage[from - E.drawn_rowoff] = 1;
+    }
+}
+
+void editorDamageAll(void)
+{
+    memset(E.damage, 1, E.screenrows);
+}
+
+/*
+ * Highlights a row from the state carried into it, which editorSyntaxPrepare
+ * has made valid, into one byte per char. Returns NULL for rows where every
+ * cell is HL_NORMAL; otherwise the caller releases the size bytes.
+ */
+static unsigned char *editorRowHighlight(Erow *row)
+{
+    unsigned char *hl;
+    int j;
+
+    if (!E.syntax || !row->size)
+    {
+        return NULL;
+    }
+    hl = (unsigned char *)slabAlloc(&E.slab, row->size);
+    memset(hl, 0, row->size);
+    syntaxHighlight(E.syntax, row->chars, row->size, row->hl_state, hl);
+    for (j = 0; j < row->size && hl[j] == HL_NORMAL; j++)
+    {
+    }
+    if (j == row->size)
+    {
+        slabRelease(&E.slab, (char *)hl, row->size);
+        return NULL;
+    }
+    return hl;
+}
+
+int editorRowCxToRx(Erow *row, int cx)
+{
+    int rx = 0;
+    int j;
+    for (j = 0; j < cx; j++)
+    {
+        if (row->chars[j] == '\t')
+        {
+            rx += (TABSTOP - 1) - (rx % TABSTOP);
+        }
+        rx++;
+    }
+    return rx;
+}
+
+int editorRowRxToCx(Erow *row, int rx)
+{
+    int cur_rx = 0;
+    int cx;
+    for (cx = 0; cx < row->size; cx++)
+    {
+        if (row->chars[cx] == '\t')
+        {
+            cur_rx += (TABSTOP - 1) - (cur_rx % TABSTOP);
+        }
+        cur_rx++;
+        if (cur_rx > rx)
+        {
+            return cx;
+        }
+    }
+    return cx;
+}
+
+/* Bytes taken by a render block, header included. */
+static size_t editorRenderBytes(int rsize, int flags)
+{
+    size_t bytes = sizeof(Erender);
+
+    if (!(flags & RENDER_SHARED))
+    {
+        bytes += rsize + 1;
+    }
+    if (!(flags & RENDER_PLAIN))
+    {
+        bytes += rsize;
+    }
+    return bytes;
+}
+
+static void editorRenderUnlink(Erender *r)
+{
+    if (r->prev)
+    {
+        r->prev->next = r->next;
+    }
+    else
+    {
+        E.render_oldest = r->next;
+    }
+    if (r->next)
+    {
+        r->next->prev = r->prev;
+    }
+    else
+    {
+        E.render_newest = r->prev;
+    }
+}
+
+/* Marks a cached render as drawn this frame, the last to be evicted. */
+static void editorRenderTouch(Erender *r)
+{
+    if (r != E.render_newest)
+    {
+        if (r->prev || r == E.render_oldest)
+        {
+            editorRenderUnlink(r);
+        }
+        r->prev = E.render_newest;
+        r->next = NULL;
+        if (E.render_newest)
+        {
+            E.render_newest->next = r;
+        }
+        else
+        {
+            E.render_oldest = r;
+        }
+        E.render_newest = r;
+    }
+    r->frame = E.render_frame;
+}
+
+/* Drops the cached render and hl of a row; they are rebuilt when needed. */
+void editorRowInvalidate(Erow *row)
+{
+    if (row->render && row->render != &editorPlain)
+    {
+        size_t bytes = editorRenderBytes(
+            row->render->rsize,
+            row->render->flags
+        );
+        editorRenderUnlink(row->render);
+        slabRelease(&E.slab, (char *)row->render, bytes);
+        E.cache_bytes -= bytes;
+    }
+    row->render = NULL;
+}
+
+/* Render columns of a row whose render has been built. */
+int editorRenderSize(const Erow *row)
+{
+    return row->render->flags & RENDER_SHARED ? row->size
+                                              : row->render->rsize;
+}
+
+/* The rendered text of a row whose render has been built. */
+const char *editorRenderChars(const Erow *row)
+{
+    return row->render->flags & RENDER_SHARED ? row->chars
+                                              : (const char *)(row->render + 1);
+}
+
+/* One attribute per render column, or NULL when all are HL_NORMAL. */
+const unsigned char *editorRenderHl(const Erow *row)
+{
+    const Erender *r = row->render;
+
+    if (r->flags & RENDER_PLAIN)
+    {
+        return NULL;
+    }
+    return (const unsigned char *)(r + 1) +
+           (r->flags & RENDER_SHARED ? 0 : r->rsize + 1);
+}
+
+/*
+ * Builds the render and hl of a row as one block: the expanded text if
+ * the row has tabs, then the hl if anything is highlighted. A row that
+ * needs neither points at the shared editorPlain and takes no memory.
+ */
+void editorUpdateRow(Erow *row)
+{
+    double start = statsNow();
+    unsigned char *hl;
+    Erender *r;
+    char *render;
+    unsigned char *rhl;
+    size_t bytes;
+    int rsize;
+    int flags = 0;
+    int j;
+    int idx;
+
+    editorRowInvalidate(row);
+    rsize = editorRowCxToRx(row, row->size);
+    hl = editorRowHighlight(row);
+    if (rsize == row->size)
+    {
+        flags |= RENDER_SHARED;
+    }
+    if (!hl)
+    {
+        flags |= RENDER_PLAIN;
+    }
+    if (flags == (RENDER_SHARED | RENDER_PLAIN))
+    {
+        row->render = &editorPlain;
+        statsAdd(STAT_UPDATE_ROW, start);
+        return;
+    }
+
+    bytes = editorRenderBytes(rsize, flags);
+    r = (Erender *)slabAlloc(&E.slab, bytes);
+    r->rsize = rsize;
+    r->flags = flags;
+    r->row = row;
+    r->prev = NULL;
+    r->next = NULL;
+    editorRenderTouch(r);
+    row->render = r;
+    E.cache_bytes += bytes;
+
+    render = (char *)editorRenderChars(row);
+    rhl = (unsigned char *)editorRenderHl(row);
+    idx = 0;
+    for (j = 0; j < row->size; j++)
+    {
+        int next = row->chars[j] == '\t' ? (idx / TABSTOP + 1) * TABSTOP
+                                         : idx + 1;
+        while (idx < next)
+        {
+            if (!(flags & RENDER_SHARED))
+            {
+                render[idx] = row->chars[j] == '\t' ? ' ' : row->chars[j];
+            }
+            if (rhl)
+            {
+                rhl[idx] = hl[j];
+            }
+            idx++;
+        }
+    }
+    if (!(flags & RENDER_SHARED))
+    {
+        render[idx] = '\0';
+    }
+    if (hl)
+    {
+        slabRelease(&E.slab, (char *)hl, row->size);
+    }
+    statsAdd(STAT_UPDATE_ROW, start);
+}
+
+/* Gives a row that still points into the file mapping its own copy. */
+void editorRowMakeOwned(Erow *row)
+{
+    char *chars;
+    if (!(row->flags & ROW_VIEW))
+    {
+        return;
+    }
+    chars = slabAlloc(&E.slab, row->size + 1);
+    memcpy(chars, row->chars, row->size);
+    chars[row->size] = '\0';
+    row->chars = chars;
+    row->flags &= ~ROW_VIEW;
+}
+
+/* Gets a row ready for changes to its chars. */
+void editorRowModify(Erow *row)
+{
+    editorSearchStop();
+    editorRowInvalidate(row);
+    editorRowMakeOwned(row);
+}
+
+/* Fills in render and hl of a row that is about to be drawn. */
+void editorRowRender(Erow *row)
+{
+    if (!row->render)
+    {
+        editorUpdateRow(row);
+    }
+    else if (row->render != &editorPlain)
+    {
+        editorRenderTouch(row->render);
+    }
+}
+
+/*
+ * Makes sure every row before `upto` starts from the right highlight
+ * state. States are walked forward from the first unknown row without
+ * building hl, so only rows up to the bottom of the screen are looked at.
+ */
+void editorSyntaxPrepare(int upto)
+{
+    BufferIter it;
+    Erow *row;
+    Erow *next;
+
+    if (!E.syntax || E.hl_valid >= upto || !E.numrows)
+    {
+        return;
+    }
+    if (E.hl_valid == 0)
+    {
+        row = bufferGet(&E.buf, 0);
+        if (row->hl_state != HL_STATE_NORMAL)
+        {
+            row->hl_state = HL_STATE_NORMAL;
+            editorRowInvalidate(row);
+        }
+        E.hl_valid = 1;
+    }
+    bufferIterInit(&E.buf, &it, E.hl_valid - 1);
+    row = bufferIterNext(&it);
+    while (E.hl_valid < upto && (next = bufferIterNext(&it)))
+    {
+        int state = syntaxHighlight(
+            E.syntax,
+            row->chars,
+            row->size,
+            row->hl_state,
+            NULL
+        );
+        if (next->hl_state != state)
+        {
+            next->hl_state = state;
+            editorRowInvalidate(next);
+        }
+        E.hl_valid++;
+        row = next;
+    }
+}
+
+/*
+ * Carries highlight state forward after rows from..to changed. Walking
+ * stops at the first row past `to` whose incoming state is unchanged, so
+ * an edit only re-highlights the rows it actually affects.
+ */
+void editorSyntaxUpdate(int from, int to)
+{
+    BufferIter it;
+    Erow *row;
+    Erow *next;
+    int at = from > 0 ? from - 1 : 0;
+
+    if (!E.syntax || from >= E.hl_valid)
+    {
+        return;
+    }
+    bufferIterInit(&E.buf, &it, at);
+    row = bufferIterNext(&it);
+    if (!row)
+    {
+        return;
+    }
+    if (at == 0 && row->hl_state != HL_STATE_NORMAL)
+    {
+        row->hl_state = HL_STATE_NORMAL;
+        editorRowInvalidate(row);
+        editorDamageRows(0, 0);
+    }
+    while (at + 1 < E.hl_valid && (next = bufferIterNext(&it)))
+    {
+        int state = syntaxHighlight(
+            E.syntax,
+            row->chars,
+            row->size,
+            row->hl_state,
+            NULL
+        );
+        if (next->hl_state == state)
+        {
+            if (at >= to)
+            {
+                break;
+            }
+        }
+        else
+        {
+            next->hl_state = state;
+            editorRowInvalidate(next);
+            editorDamageRows(at + 1, at + 1);
+        }
+        row = next;
+        at++;
+    }
+}
+
+void editorSyntaxRowsInserted(int at, int n)
+{
+    if (at < E.hl_valid)
+    {
+        E.hl_valid += n;
+        editorSyntaxUpdate(at, at + n - 1);
+    }
+}
+
+void editorSyntaxRowsDeleted(int at, int n)
+{
+    if (at < E.hl_valid)
+    {
+        E.hl_valid = E.hl_valid >= at + n ? E.hl_valid - n : at;
+        editorSyntaxUpdate(at, at);
+    }
+}
+
+/* Picks highlighting from the filename and drops everything cached. */
+void editorSelectSyntax(void)
+{
+    BufferIter it;
+    Erow *row;
+
+    E.syntax = syntaxSelect(E.filename);
+    E.hl_valid = 0;
+    bufferIterInit(&E.buf, &it, 0);
+    while ((row = bufferIterNext(&it)))
+    {
+        editorRowInvalidate(row);
+    }
+    editorDamageAll();
+}
+
+void editorRowInsertString(Erow *row, int at, const char *s, size_t len)
+{
+    editorRowModify(row);
+    row->chars = slabResize(
+        &E.slab,
+        row->chars,
+        row->size + 1,
+        row->size + len + 1
+    );
+    memmove(&row->chars[at + len], &row->chars[at], row->size - at + 1);
+    memcpy(&row->chars[at], s, len);
+    row->size += len;
+    E.dirty++;
+}
+
+void editorRowAppendString(Erow *row, char *s, size_t len)
+{
+    editorRowInsertString(row, row->size, s, len);
+}
+
+void editorRowDelString(Erow *row, int at, int len)
+{
+    editorRowModify(row);
+    memmove(&row->chars[at], &row->chars[at + len], row->size - at - len + 1);
+    row->chars = slabResize(
+        &E.slab,
+        row->chars,
+        row->size + 1,
+        row->size - len + 1
+    );
+    row->size -= len;
+    E.dirty++;
+}
+
+void editorFreeRow(Erow *row)
+{
+    editorRowInvalidate(row);
+    if (!(row->flags & ROW_VIEW))
+    {
+        slabRelease(&E.slab, row->chars, row->size + 1);
+    }
+}
+
+/* Redraws and rescans rows from..to after their chars changed. */
+static void editorRowsChanged(int from, int to)
+{
+    editorDamageRows(from, to);
+    editorSyntaxUpdate(from, to);
+    editorMatchesUpdate(from, to);
+}
+
+/*
+ * Inserts `n` rows at `at` from text[0, len), where they are separated
+ * by newlines, with one tree insert however many there are. Nothing is
+ * recorded for undo; see editorInsertRows.
+ */
+static void editorAddRows(int at, const char *text, size_t len, int n)
+{
+    Erow *rows = malloc(sizeof(Erow) * n);
+    const char *end = text + len;
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        const char *nl = i + 1 < n ? memchr(text, '\n', end - text) : end;
+        Erow *row = &rows[i];
+
+        row->size = nl - text;
+        row->chars = slabAlloc(&E.slab, row->size + 1);
+        memcpy(row->chars, text, row->size);
+        row->chars[row->size] = '\0';
+        row->render = NULL;
+        row->flags = 0;
+        row->hl_state = HL_STATE_NORMAL;
+        row->matches =
+            E.query ? editorCountMatches(text, row->size, row->size) : 0;
+        if (i + 1 < n)
+        {
+            text = nl + 1;
+        }
+    }
+    editorSearchStop();
+    bufferInsert(&E.buf, at, rows, n);
+    free(rows);
+    editorDamageRows(at, -1);
+
+    E.numrows += n;
+    E.dirty++;
+    editorSyntaxRowsInserted(at, n);
+}
+
+/* Deletes `n` rows from `at` without recording anything for undo. */
+static void editorRemoveRows(int at, int n)
+{
+    BufferIter it;
+    int i;
+
+    editorSearchStop();
+    bufferIterInit(&E.buf, &it, at);
+    for (i = 0; i < n; i++)
+    {
+        editorFreeRow(bufferIterNext(&it));
+    }
+    bufferDelete(&E.buf, at, n);
+    editorDamageRows(at, -1);
+    E.numrows -= n;
+    E.dirty++;
+    editorSyntaxRowsDeleted(at, n);
+}
+
+void editorInsertRows(int at, const char *text, size_t len, int n)
+{
+    double start = statsNow();
+    char *undo;
+
+    if (at < 0 || at > E.numrows || n <= 0)
+    {
+        return;
+    }
+    undo = undoPush(&E.undo, UNDO_INSERT_ROWS, at, 0, n, len);
+    if (undo)
+    {
+        memcpy(undo, text, len);
+    }
+    editorAddRows(at, text, len, n);
+    statsAdd(STAT_INSERT_ROWS, start);
+}
+
+void editorInsertRow(int at, char *s, size_t len)
+{
+    editorInsertRows(at, s, len, 1);
+}
+
+/* Length of rows at..at + n - 1 joined by newlines. */
+size_t editorRowsLength(int at, int n)
+{
+    BufferIter it;
+    size_t len = 0;
+    int i;
+
+    bufferIterInit(&E.buf, &it, at);
+    for (i = 0; i < n; i++)
+    {
+        len += bufferIterNext(&it)->size + 1;
+    }
+    return len - 1;
+}
+
+/* Copies rows at..at + n - 1 joined by newlines to `dst`. */
+void editorRowsCopy(int at, int n, char *dst)
+{
+    BufferIter it;
+    int i;
+
+    bufferIterInit(&E.buf, &it, at);
+    for (i = 0; i < n; i++)
+    {
+        Erow *row = bufferIterNext(&it);
+        memcpy(dst, row->chars, row->size);
+        dst += row->size;
+        if (i + 1 < n)
+        {
+            *dst++ = '\n';
+        }
+    }
+}
+
+/* Deletes `n` rows from `at`, keeping their text as one undo op. */
+void editorDelRows(int at, int n)
+{
+    double start = statsNow();
+    char *undo;
+
+    if (at < 0 || at >= E.numrows || n <= 0)
+    {
+        return;
+    }
+    if (n > E.numrows - at)
+    {
+        n = E.numrows - at;
+    }
+    undo = undoPush(
+        &E.undo,
+        UNDO_DELETE_ROWS,
+        at,
+        0,
+        n,
+        editorRowsLength(at, n)
+    );
+    if (undo)
+    {
+        editorRowsCopy(at, n, undo);
+    }
+    editorRemoveRows(at, n);
+    statsAdd(STAT_DEL_ROWS, start);
+}
+
+void editorDelRow(int at)
+{
+    editorDelRows(at, 1);
+}
+
+/* Inserts s[0, len), which holds no newline, into row `at` at `col`. */
+void editorInsertText(int at, int col, const char *s, size_t len)
+{
+    char *undo = undoPush(&E.undo, UNDO_INSERT_TEXT, at, col, 1, len);
+
+    if (undo)
+    {
+        memcpy(undo, s, len);
+    }
+    editorRowInsertString(bufferGet(&E.buf, at), col, s, len);
+    editorRowsChanged(at, at);
+}
+
+void editorDeleteText(int at, int col, int len)
+{
+    Erow *row = bufferGet(&E.buf, at);
+    char *undo = undoPush(&E.undo, UNDO_DELETE_TEXT, at, col, 1, len);
+
+    if (undo)
+    {
+        memcpy(undo, &row->chars[col], len);
+    }
+    editorRowDelString(row, col, len);
+    editorRowsChanged(at, at);
+}
+
+/* Breaks row `at` in two before column `col`. */
+void editorSplitRow(int at, int col)
+{
+    Erow *row = bufferGet(&E.buf, at);
+
+    undoPush(&E.undo, UNDO_SPLIT_ROW, at, col, 1, 0);
+    editorAddRows(at + 1, &row->chars[col], row->size - col, 1);
+    row = bufferGet(&E.buf, at);
+    editorRowModify(row);
+    row->chars = slabResize(&E.slab, row->chars, row->size + 1, col + 1);
+    row->size = col;
+    row->chars[row->size] = '\0';
+    editorRowsChanged(at, at + 1);
+}
+
+/* Appends row at + 1 to row `at`. */
+void editorJoinRow(int at)
+{
+    Erow *row = bufferGet(&E.buf, at);
+    Erow *next = bufferGet(&E.buf, at + 1);
+
+    undoPush(&E.undo, UNDO_JOIN_ROW, at, row->size, 1, 0);
+    editorRowAppendString(row, next->chars, next->size);
+    editorRemoveRows(at + 1, 1);
+    editorRowsChanged(at, at);
+}
+
+/*
+ * Inserts text[0, len), which may span lines, into row `at` before `col`
+ * and stores where the text ends. Row `at` is split around the text and
+ * all its inner lines go in with one bulk row insert, so the cost is
+ * linear in the text whatever its shape.
+ */
+void editorSpliceText(
+    int at,
+    int col,
+    const char *text,
+    size_t len,
+    int *end_at,
+    int *end_col
+)
+{
+    const char *end = text + len;
+    const char *first = memchr(text, '\n', len);
+    const char *last = first;
+    const char *nl;
+    int n = 1;
+
+    if (at == E.numrows)
+    {
+        editorInsertRow(at, "", 0);
+    }
+    if (!first)
+    {
+        editorInsertText(at, col, text, len);
+        *end_at = at;
+        *end_col = col + len;
+        return;
+    }
+    while ((nl = memchr(last + 1, '\n', end - last - 1)))
+    {
+        last = nl;
+        n++;
+    }
+
+    editorSplitRow(at, col);
+    editorInsertText(at, col, text, first - text);
+    if (n > 1)
+    {
+        editorInsertRows(at + 1, first + 1, last - first - 1, n - 1);
+    }
+    editorInsertText(at + n, 0, last + 1, end - last - 1);
+    *end_at = at + n;
+    *end_col = end - last - 1;
+}
+
+/* Text from (fy, fx) up to but not including (ty, tx), newlines included. */
+char *editorRangeText(int fy, int fx, int ty, int tx, size_t *len)
+{
+    Erow *first = bufferGet(&E.buf, fy);
+    int middle = ty - fy - 1;
+    size_t mlen = middle > 0 ? editorRowsLength(fy + 1, middle) + 1 : 0;
+    char *text;
+    char *p;
+
+    if (fy == ty)
+    {
+        *len = tx - fx;
+        text = malloc(*len + 1);
+        memcpy(text, &first->chars[fx], *len);
+        return text;
+    }
+    *len = first->size - fx + 1 + mlen + tx;
+    text = malloc(*len + 1);
+    p = text;
+    memcpy(p, &first->chars[fx], first->size - fx);
+    p += first->size - fx;
+    *p++ = '\n';
+    if (middle > 0)
+    {
+        editorRowsCopy(fy + 1, middle, p);
+        p += mlen - 1;
+        *p++ = '\n';
+    }
+    memcpy(p, bufferGet(&E.buf, ty)->chars, tx);
+    return text;
+}
+
+/*
+ * Deletes from (fy, fx) up to but not including (ty, tx). The rows in
+ * between go with one bulk delete and only the two boundary rows are
+ * edited, so the cost does not depend on how many lines are covered.
+ */
+void editorDeleteRange(int fy, int fx, int ty, int tx)
+{
+    Erow *first;
+
+    if (fy == ty)
+    {
+        if (tx > fx)
+        {
+            editorDeleteText(fy, fx, tx - fx);
+        }
+        return;
+    }
+    if (tx > 0)
+    {
+        editorDeleteText(ty, 0, tx);
+    }
+    editorDelRows(fy + 1, ty - fy - 1);
+    first = bufferGet(&E.buf, fy);
+    if (first->size > fx)
+    {
+        editorDeleteText(fy, fx, first->size - fx);
+    }
+    editorJoinRow(fy);
+}
+
+/*
+ * Indents (direction > 0) or unindents rows from..to by TABSTOP columns,
+ * replacing them all with one bulk delete and one bulk insert. Empty
+ * rows are not indented, and unindenting takes off up to TABSTOP spaces
+ * or a single tab.
+ */
+void editorShiftRows(int from, int to, int direction)
+{
+    BufferIter it;
+    int n = to - from + 1;
+    char *text = malloc(editorRowsLength(from, n) + (size_t)n * TABSTOP + 1);
+    size_t len = 0;
+    int changed = 0;
+    int i;
+
+    bufferIterInit(&E.buf, &it, from);
+    for (i = 0; i < n; i++)
+    {
+        Erow *row = bufferIterNext(&it);
+        int skip = 0;
+
+        if (direction > 0 && row->size > 0)
+        {
+            memset(&text[len], ' ', TABSTOP);
+            len += TABSTOP;
+        }
+        else if (direction < 0 && row->size > 0 && row->chars[0] == '\t')
+        {
+            skip = 1;
+        }
+        else if (direction < 0)
+        {
+            while (skip < TABSTOP && skip < row->size &&
+                   row->chars[skip] == ' ')
+            {
+                skip++;
+            }
+        }
+        changed |= direction > 0 ? row->size > 0 : skip > 0;
+        memcpy(&text[len], &row->chars[skip], row->size - skip);
+        len += row->size - skip;
+        if (i + 1 < n)
+        {
+            text[len++] = '\n';
+        }
+    }
+    if (changed)
+    {
+        editorDelRows(from, n);
+        editorInsertRows(from, text, len, n);
+    }
+    free(text);
+}
+
+void editorInsertChar(int c)
+{
+    char ch = c;
+    Erow *row;
+
+    if (E.cy == E.numrows)
+    {
+        editorInsertRow(E.numrows, "", 0);
+    }
+    row = bufferGet(&E.buf, E.cy);
+    if (E.cx > row->size)
+    {
+        E.cx = row->size;
+    }
+    editorInsertText(E.cy, E.cx, &ch, 1);
+    E.cx++;
+}
+
+void editorDelChar(void)
+{
+    Erow *row;
+
+    if (E.cy == E.numrows)
+    {
+        return;
+    }
+    if (E.cx == 0 && E.cy == 0)
+    {
+        return;
+    }
+    row = bufferGet(&E.buf, E.cy);
+    if (E.cx > 0)
+    {
+        if (E.cx <= row->size)
+        {
+            editorDeleteText(E.cy, E.cx - 1, 1);
+        }
+        E.cx--;
+    }
+    else
+    {
+        E.cx = bufferGet(&E.buf, E.cy - 1)->size;
+        editorJoinRow(E.cy - 1);
+        E.cy--;
+    }
+}
+
+void editorInsertNewline(void)
+{
+    Erow *row = bufferGet(&E.buf, E.cy);
+
+    if (row && E.cx > row->size)
+    {
+        E.cx = row->size;
+    }
+    if (E.cx == 0 || !row)
+    {
+        editorInsertRow(E.cy, "", 0);
+    }
+    else
+    {
+        editorSplitRow(E.cy, E.cx);
+    }
+    E.cy++;
+    E.cx = 0;
+}
+
+/*
+ * Puts text that the caller allocated into the register chosen for the
+ * command, or the unnamed one, and makes it what a plain paste uses.
+ */
+void editorRegisterStore(char *text, size_t len, int linewise)
+{
+    Register *r = &E.registers[E.reg];
+
+    free(r->text);
+    r->text = text;
+    r->len = len;
+    r->linewise = linewise;
+    E.unnamed = E.reg;
+}
+
+/* Yanks rows at..at + n - 1 as lines. */
+void editorYankRows(int at, int n)
+{
+    size_t len = editorRowsLength(at, n);
+    char *text = malloc(len + 1);
+
+    editorRowsCopy(at, n, text);
+    editorRegisterStore(text, len, 1);
+}
+
+/*
+ * Pastes a register `count` times after (`after` set) or before the
+ * cursor: lines go below or above the cursor row, anything else into the
+ * row itself, and either way all copies go in with one bulk insert.
+ */
+void editorPaste(int after, int count)
+{
+    Register *r = &E.registers[E.reg ? E.reg : E.unnamed];
+    Erow *row = bufferGet(&E.buf, E.cy);
+    char *text;
+    size_t len;
+    int at;
+    int col;
+    int i;
+
+    if (!r->text)
+    {
+        return;
+    }
+    text = r->text;
+    len = r->len;
+    if (count > 1)
+    {
+        len = r->len * count + (r->linewise ? count - 1 : 0);
+        text = malloc(len + 1);
+        for (i = 0; i < count; i++)
+        {
+            char *p = &text[(r->len + (r->linewise ? 1 : 0)) * i];
+            memcpy(p, r->text, r->len);
+            if (r->linewise && i + 1 < count)
+            {
+                p[r->len] = '\n';
+            }
+        }
+    }
+    if (r->linewise)
+    {
+        const char *nl = r->text;
+        int n = 1;
+
+        while ((nl = memchr(nl, '\n', r->text + r->len - nl)))
+        {
+            nl++;
+            n++;
+        }
+        at = row && after ? E.cy + 1 : E.cy;
+        editorInsertRows(at, text, len, n * count);
+        E.cy = at;
+        E.cx = 0;
+    }
+    else
+    {
+        col = E.cx;
+        if (row && after && row->size > 0)
+        {
+            col++;
+        }
+        if (row && col > row->size)
+        {
+            col = row->size;
+        }
+        E.cx = col;
+        editorSpliceText(E.cy, E.cx, text, len, &at, &col);
+        if (at == E.cy && col > 0)
+        {
+            E.cx = col - 1;
+        }
+    }
+    if (text != r->text)
+    {
+        free(text);
+    }
+}
+
+/*
+ * Puts text pasted into the terminal in at the cursor with one splice,
+ * as an undo step of its own. Terminals send the newlines of a paste as
+ * carriage returns, so each CR or CR LF becomes one newline, in place.
+ * The cursor ends after the text, or on its last char outside insert.
+ */
+void editorPasteText(char *text, size_t len)
+{
+    Erow *row = bufferGet(&E.buf, E.cy);
+    size_t n = 0;
+    size_t i;
+    int at;
+    int col;
+
+    for (i = 0; i < len; i++)
+    {
+        if (text[i] == '\r')
+        {
+            text[n++] = '\n';
+            if (i + 1 < len && text[i + 1] == '\n')
+            {
+                i++;
+            }
+        }
+        else
+        {
+            text[n++] = text[i];
+        }
+    }
+    if (!n)
+    {
+        return;
+    }
+    if (row && E.cx > row->size)
+    {
+        E.cx = row->size;
+    }
+    undoBegin(&E.undo, E.cx, E.cy);
+    editorSpliceText(E.cy, E.cx, text, n, &at, &col);
+    E.cy = at;
+    E.cx = E.mode != INSERT && col > 0 ? col - 1 : col;
+    undoBegin(&E.undo, E.cx, E.cy);
+}
+
+/*
+ * Sets row `at` to text[0, len) and recounts its matches of the query.
+ * The caller redraws and restarts syntax.
+ */
+static void editorRowSwap(int at, Erow *row, const char *text, int len)
+{
+    editorSearchStop();
+    editorRowInvalidate(row);
+    if (!(row->flags & ROW_VIEW))
+    {
+        row->chars = slabResize(&E.slab, row->chars, row->size + 1, len + 1);
+    }
+    else
+    {
+        row->chars = slabAlloc(&E.slab, len + 1);
+    }
+    memcpy(row->chars, text, len);
+    row->chars[len] = '\0';
+    row->size = len;
+    row->flags &= ~ROW_VIEW;
+    editorMatchesUpdate(at, at);
+}
+
+/*
+ * Sets the rows of an UNDO_REPLACE_ROWS op to their new text, or with
+ * `restore` to their old. Each of its n records is the row, the old and
+ * new lengths as ints, then the old and the new text; the rows ascend,
+ * so they are reached in one walk.
+ */
+static void editorReplaceRows(const UndoOp *op, int restore)
+{
+    const char *p = op->text;
+    BufferIter it;
+    int at = op->at;
+    int i;
+
+    /* workers still counting would read the chars swapped out here */
+    editorSearchStop();
+    bufferIterInit(&E.buf, &it, at);
+    for (i = 0; i < op->n; i++)
+    {
+        int rec[3];
+
+        memcpy(rec, p, sizeof(rec));
+        p += sizeof(rec);
+        while (at < rec[0])
+        {
+            bufferIterNext(&it);
+            at++;
+        }
+        editorRowSwap(
+            at,
+            bufferIterNext(&it),
+            restore ? p : p + rec[1],
+            restore ? rec[1] : rec[2]
+        );
+        at++;
+        p += rec[1] + rec[2];
+    }
+    editorDamageRows(op->at, -1);
+    if (op->at < E.hl_valid)
+    {
+        E.hl_valid = op->at;
+    }
+}
+
+/* Applies an op, or with `undo` set its inverse, with recording paused. */
+static void editorUndoApply(UndoOp *op, int undo)
+{
+    switch (undo ? op->type ^ 1 : op->type)
+    {
+    case UNDO_INSERT_TEXT:
+        editorInsertText(op->at, op->col, op->text, op->len);
+        break;
+    case UNDO_DELETE_TEXT:
+        editorDeleteText(op->at, op->col, op->len);
+        break;
+    case UNDO_SPLIT_ROW:
+        editorSplitRow(op->at, op->col);
+        break;
+    case UNDO_JOIN_ROW:
+        editorJoinRow(op->at);
+        break;
+    case UNDO_INSERT_ROWS:
+        editorInsertRows(op->at, op->text, op->len, op->n);
+        break;
+    case UNDO_DELETE_ROWS:
+        editorDelRows(op->at, op->n);
+        break;
+    case UNDO_REPLACE_ROWS:
+        editorReplaceRows(op, 0);
+        break;
+    case UNDO_RESTORE_ROWS:
+        editorReplaceRows(op, 1);
+        break;
+    }
+}
+
+/*
+ * Undoes (direction < 0) or redoes the last group of edits. Undo puts
+ * the cursor back where the group began, redo on its first edit.
+ * Returns 0 when there is nothing left to undo or redo.
+ */
+int editorUndo(int direction)
+{
+    UndoOp *ops;
+    Erow *row;
+    int n = undoStep(&E.undo, direction, &ops);
+    int i;
+
+    if (n == 0)
+    {
+        editorSetStatusMessage(
+            direction < 0 ? "Already at oldest change"
+                          : "Already at newest change"
+        );
+        return 0;
+    }
+    E.undo.replaying = 1;
+    for (i = 0; i < n; i++)
+    {
+        if (direction < 0)
+        {
+            editorUndoApply(&ops[n - 1 - i], 1);
+        }
+        else
+        {
+            editorUndoApply(&ops[i], 0);
+        }
+    }
+    E.undo.replaying = 0;
+
+    E.cy = direction < 0 ? ops[0].cy : ops[0].at;
+    E.cx = direction < 0 ? ops[0].cx : ops[0].col;
+    if (E.cy >= E.numrows)
+    {
+        E.cy = E.numrows ? E.numrows - 1 : 0;
+    }
+    row = bufferGet(&E.buf, E.cy);
+    if (!row)
+    {
+        E.cx = 0;
+    }
+    else if (E.cx > (row->size ? row->size - 1 : 0))
+    {
+        E.cx = row->size ? row->size - 1 : 0;
+    }
+    return n;
+}
+
+/* Undo log size in bytes, from OCEAN_UNDO_MB if that is set. */
+static size_t editorUndoLimit(void)
+{
+    const char *mb = getenv("OCEAN_UNDO_MB");
+    char *end;
+    unsigned long n;
+
+    if (!mb)
+    {
+        return UNDO_LIMIT;
+    }
+    n = strtoul(mb, &end, 10);
+    return *mb && !*end ? (size_t)n * 1024 * 1024 : UNDO_LIMIT;
+}
+
+/*
+ * Sets up an empty editor for a screen of `screenrows` text rows. Only
+ * the front end draws them, but edits mark the ones to redraw either way.
+ */
+void editorInit(int screenrows)
+{
+    int i;
+
+    E.cx = 0;
+    E.cy = 0;
+    E.rx = 0;
+    E.rowoff = 0;
+    E.coloff = 0;
+    E.screenrows = screenrows;
+    E.numrows = 0;
+    bufferInit(&E.buf);
+    E.dirty = 0;
+    E.filename = NULL;
+    E.map = NULL;
+    E.map_size = 0;
+    E.indexing = 0;
+    E.indexed = 0;
+    E.cache_bytes = 0;
+    E.render_oldest = NULL;
+    E.render_newest = NULL;
+    E.render_frame = 0;
+    E.syntax = NULL;
+    E.hl_valid = 0;
+    searchPoolInit(&E.search);
+    E.searching = 0;
+    E.query = NULL;
+    E.regex = NULL;
+    E.use_regex = 0;
+    E.regex_error = NULL;
+    E.counting = 0;
+    E.match_ready = 0;
+    undoInit(&E.undo, editorUndoLimit());
+    slabInit(&E.slab);
+    E.statusmsg[0] = '\0';
+    E.statusmsg_time = 0;
+    E.mode = NORMAL;
+    E.selection_x = 0;
+    E.selection_y = 0;
+    E.damage = malloc(E.screenrows);
+    editorDamageAll();
+    E.drawn_rowoff = 0;
+    E.drawn_coloff = 0;
+    E.drawn_cols = 0;
+    E.drawn_cy = 0;
+    E.drawn_mode = NORMAL;
+    for (i = 0; i < REGISTERS; i++)
+    {
+        E.registers[i].text = NULL;
+        E.registers[i].len = 0;
+        E.registers[i].linewise = 0;
+    }
+    E.reg = 0;
+    E.unnamed = 0;
+    E.count = 0;
+    E.op = 0;
+    E.opcount = 0;
+    E.pending = 0;
+    E.quit = 0;
+}
+
+
+/*
+ * Moves up to `limit` lines found by the background index into the buffer
+ * (all of them if `limit` is negative). Rows point straight into the
+ * mapping; nothing is copied until a row is edited, and render/hl are
+ * built when a row is first drawn. Everything not yet indexed lies after
+ * the rows already loaded, so new rows are always appended.
+ */
+void editorIngest(int limit)
+{
+    Erow batch[LOAD_BATCH];
+    int done;
+    int avail;
+    int n = 0;
+
+    if (!E.indexing)
+    {
+        return;
+    }
+    avail = lineIndexLines(&E.index, &done);
+    if (limit >= 0 && avail > E.indexed + limit)
+    {
+        avail = E.indexed + limit;
+        done = 0;
+    }
+    editorDamageRows(E.numrows, -1);
+    while (E.indexed < avail)
+    {
+        const char *start;
+        size_t len;
+        lineIndexLine(&E.index, E.indexed++, &start, &len);
+        while (len > 0 && start[len - 1] == '\r')
+        {
+            len--;
+        }
+        batch[n].size = len;
+        batch[n].chars = (char *)start;
+        batch[n].render = NULL;
+        batch[n].flags = ROW_VIEW;
+        batch[n].hl_state = HL_STATE_NORMAL;
+        batch[n].matches = 0;
+        if (++n == LOAD_BATCH)
+        {
+            bufferInsert(&E.buf, E.numrows, batch, n);
+            E.numrows += n;
+            n = 0;
+        }
+    }
+    bufferInsert(&E.buf, E.numrows, batch, n);
+    E.numrows += n;
+
+    if (done)
+    {
+        lineIndexFree(&E.index);
+        E.indexing = 0;
+    }
+}
+
+/* Blocks until the whole mapped file has been indexed and loaded. */
+void editorIndexFinish(void)
+{
+    if (E.indexing)
+    {
+        lineIndexWait(&E.index);
+        editorIngest(-1);
+    }
+}
+
+/* Rows in the document, counting lines the index has found but not loaded. */
+int editorTotalRows(void)
+{
+    if (E.indexing)
+    {
+        return E.numrows + lineIndexLines(&E.index, NULL) - E.indexed;
+    }
+    return E.numrows;
+}
+
+void editorOpenMapping(char *map, size_t size)
+{
+    E.map = map;
+    E.map_size = size;
+    E.indexed = 0;
+    E.indexing = 1;
+    lineIndexStart(&E.index, map, size);
+}
+
+
+static void editorOpenFile(char *filename)
+{
+    FILE *fp;
+    char *line = NULL;
+    size_t linecap = 0;
+    ssize_t linelen;
+    struct stat st;
+    int fd = open(filename, O_RDONLY);
+    free(E.filename);
+    E.filename = strdup(filename);
+    E.syntax = syntaxSelect(E.filename);
+
+    if (fd == -1)
+    {
+        die("open");
+    }
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        char *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED)
+        {
+            close(fd);
+            editorOpenMapping(map, st.st_size);
+            E.dirty = 0;
+            return;
+        }
+    }
+
+    fp = fdopen(fd, "r");
+    if (!fp)
+    {
+        die("fdopen");
+    }
+
+    while ((linelen = getline(&line, &linecap, fp)) != -1)
+    {
+        while (linelen > 0 &&
+               (line[linelen - 1] == '\n' || line[linelen - 1] == '\r'))
+        {
+            linelen--;
+        }
+        editorAddRows(E.numrows, line, linelen, 1);
+    }
+    free(line);
+    fclose(fp);
+    E.dirty = 0;
+}
+
+void editorOpen(char *filename)
+{
+    double start = statsNow();
+    editorOpenFile(filename);
+    statsAdd(STAT_OPEN, start);
+}
+
+/* Writes out a batch of iovecs, resuming after short writes. */
+int editorWritev(int fd, struct iovec *iov, int n)
+{
+    while (n > 0)
+    {
+        ssize_t w = writev(fd, iov, n);
+        if (w == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        while (n > 0 && (size_t)w >= iov->iov_len)
+        {
+            w -= iov->iov_len;
+            iov++;
+            n--;
+        }
+        if (n > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + w;
+            iov->iov_len -= w;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Streams every row into `fd` with batched writev calls, never building a
+ * copy of the document. Unedited rows that sit back to back in the file
+ * mapping are written together with their newlines as a single iovec.
+ */
+int editorWriteRows(int fd, size_t *written)
+{
+    static char newline[] = "\n";
+    struct iovec iov[SAVE_IOV];
+    BufferIter it;
+    Erow *row;
+    int n = 0;
+
+    *written = 0;
+    bufferIterInit(&E.buf, &it, 0);
+    while ((row = bufferIterNext(&it)))
+    {
+        size_t len = row->size;
+        char *prev = NULL;
+        int nl = (row->flags & ROW_VIEW) &&
+                 row->chars + len < E.map + E.map_size &&
+                 row->chars[len] == '\n';
+        if (n > 0)
+        {
+            prev = (char *)iov[n - 1].iov_base + iov[n - 1].iov_len;
+        }
+        if (nl)
+        {
+            len++;
+        }
+        if (prev == row->chars)
+        {
+            iov[n - 1].iov_len += len;
+        }
+        else
+        {
+            iov[n].iov_base = row->chars;
+            iov[n].iov_len = len;
+            n++;
+        }
+        if (!nl)
+        {
+            iov[n].iov_base = newline;
+            iov[n].iov_len = 1;
+            n++;
+        }
+        *written += row->size + 1;
+
+        if (n >= SAVE_IOV - 1)
+        {
+            if (editorWritev(fd, iov, n) == -1)
+            {
+                return -1;
+            }
+            n = 0;
+        }
+    }
+    return editorWritev(fd, iov, n);
+}
+
+/*
+ * Saves to `path` through a temporary file in the same directory that is
+ * fsynced and then renamed over the target, so a crash leaves either the
+ * old file or the complete new one. The old inode stays alive for the
+ * file mapping. Only a save to the buffer's own file marks it clean.
+ */
+static void editorSaveFile(const char *path)
+{
+    struct stat st;
+    struct timespec start, end;
+    size_t len;
+    char *target;
+    char *tmp;
+    char *slash;
+    int fd;
+    int err = 0;
+    double ms;
+
+    editorIndexFinish();
+    if (!path)
+    {
+        editorSetStatusMessage("No file name");
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    target = realpath(path, NULL);
+    if (!target)
+    {
+        target = strdup(path);
+    }
+    tmp = malloc(strlen(target) + 8);
+    sprintf(tmp, "%s.XXXXXX", target);
+    fd = mkstemp(tmp);
+    if (fd == -1)
+    {
+        editorSetStatusMessage("Can't save! I/O error: %s", strerror(errno));
+        free(tmp);
+        free(target);
+        return;
+    }
+    if (stat(target, &st) == 0)
+    {
+        fchmod(fd, st.st_mode & 07777);
+    }
+    else
+    {
+        mode_t mask = umask(0);
+        umask(mask);
+        fchmod(fd, 0666 & ~mask);
+    }
+
+    if (editorWriteRows(fd, &len) == -1 || fsync(fd) == -1)
+    {
+        err = errno;
+        close(fd);
+    }
+    else if (close(fd) == -1 || rename(tmp, target) == -1)
+    {
+        err = errno;
+    }
+    if (err)
+    {
+        unlink(tmp);
+        editorSetStatusMessage("Can't save! I/O error: %s", strerror(err));
+        free(tmp);
+        free(target);
+        return;
+    }
+
+    slash = strrchr(target, '/');
+    if (slash)
+    {
+        *slash = '\0';
+        fd = open(*target ? target : "/", O_RDONLY);
+    }
+    else
+    {
+        fd = open(".", O_RDONLY);
+    }
+    if (fd != -1)
+    {
+        fsync(fd);
+        close(fd);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ms = (end.tv_sec - start.tv_sec) * 1e3 +
+         (end.tv_nsec - start.tv_nsec) / 1e6;
+    editorSetStatusMessage(
+        "%lu bytes written in %.1f ms (%.1f MB/s)",
+        (unsigned long)len,
+        ms,
+        ms > 0 ? len / (ms * 1e3) : 0.0
+    );
+    if (path == E.filename)
+    {
+        E.dirty = 0;
+    }
+    free(tmp);
+    free(target);
+}
+
+static void editorSaveTo(const char *path)
+{
+    double start = statsNow();
+    editorSaveFile(path);
+    statsAdd(STAT_SAVE, start);
+}
+
+void editorSave(void)
+{
+    editorSaveTo(E.filename);
+}
+
+/* Matches of the query in s[0, size) that start before column `limit`. */
+int editorCountMatches(const char *s, int size, int limit)
+{
+    int count = 0;
+    int start;
+    int end = 0;
+
+    searchMatcherRow(&E.matcher, s, size);
+    while (end < limit && searchMatch(&E.matcher, end, &start, &end) &&
+           start < limit)
+    {
+        count++;
+    }
+    return count;
+}
+
+/* Column of the `nth` match of the query in a row, or -1 if it has none. */
+static int editorRowNthMatch(Erow *row, int nth)
+{
+    int start;
+    int end = 0;
+
+    searchMatcherRow(&E.matcher, row->chars, row->size);
+    while (searchMatch(&E.matcher, end, &start, &end))
+    {
+        if (nth-- == 0)
+        {
+            return start;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Render columns covered by matches of the query in a row, as merged
+ * [from, to) pairs in scratch space that lives until the next call.
+ */
+int editorRowMatchSpans(Erow *row, int **spans)
+{
+    static int *scratch = NULL;
+    static int capacity = 0;
+    int n = 0;
+    int from;
+    int to = 0;
+    int cx = 0;
+    int rx = 0;
+
+    searchMatcherRow(&E.matcher, row->chars, row->size);
+    while (searchMatch(&E.matcher, to, &from, &to))
+    {
+        int rfrom;
+        int rto;
+        int j;
+
+        for (; cx < from; cx++)
+        {
+            rx += row->chars[cx] == '\t' ? TABSTOP - rx % TABSTOP : 1;
+        }
+        rfrom = rx;
+        rto = rx;
+        for (j = from; j < to; j++)
+        {
+            rto += row->chars[j] == '\t' ? TABSTOP - rto % TABSTOP : 1;
+        }
+        if (n > 0 && rfrom <= scratch[2 * n - 1])
+        {
+            if (rto > scratch[2 * n - 1])
+            {
+                scratch[2 * n - 1] = rto;
+            }
+        }
+        else
+        {
+            if (2 * n + 2 > capacity)
+            {
+                capacity = capacity ? capacity * 2 : 64;
+                scratch = realloc(scratch, sizeof(int) * capacity);
+            }
+            scratch[2 * n] = rfrom;
+            scratch[2 * n + 1] = rto;
+            n++;
+        }
+    }
+    *spans = scratch;
+    return n;
+}
+
+/*
+ * Keeps workers away from rows that are about to change. A count that is
+ * cut short leaves the match index unusable until the next search.
+ */
+void editorSearchStop(void)
+{
+    if (E.counting)
+    {
+        searchPoolCancel(&E.search);
+        E.counting = 0;
+        E.searching = 0;
+    }
+}
+
+/* Recounts the matches in rows from..to after their chars changed. */
+void editorMatchesUpdate(int from, int to)
+{
+    int at;
+
+    if (!E.query)
+    {
+        return;
+    }
+    for (at = from; at <= to && at < E.numrows; at++)
+    {
+        Erow *row = bufferGet(&E.buf, at);
+        bufferSetMatches(
+            &E.buf,
+            at,
+            editorCountMatches(row->chars, row->size, row->size)
+        );
+    }
+}
+
+/* Moves to a match, bringing it to the top if it is off screen. */
+static void editorFindShow(SearchPos pos)
+{
+    E.cy = pos.row;
+    E.cx = pos.col;
+    if (pos.row < E.rowoff || pos.row >= E.rowoff + E.screenrows)
+    {
+        E.rowoff = E.numrows;
+    }
+}
+
+/*
+ * Picks up what the search pool has finished: the first match moves the
+ * cursor as soon as it is known, and once every row is counted the
+ * counts are summed into the buffer's tree and the index is ready.
+ */
+void editorFindPoll(void)
+{
+    SearchPos pos;
+
+    if (E.searching)
+    {
+        switch (searchPoolPoll(&E.search, &pos))
+        {
+        case SEARCH_RUNNING:
+            break;
+        case SEARCH_FOUND:
+            editorFindShow(pos);
+            E.searching = 0;
+            break;
+        default:
+            E.searching = 0;
+            break;
+        }
+    }
+    if (E.counting && searchPoolDone(&E.search))
+    {
+        searchPoolCancel(&E.search);
+        bufferSumMatches(&E.buf);
+        E.counting = 0;
+        E.match_ready = 1;
+    }
+}
+
+static void editorFindStart(int from, int direction)
+{
+    editorSearchStop();
+    E.match_ready = 0;
+    searchPoolStart(&E.search, &E.buf, &E.pattern, from, direction);
+    E.counting = 1;
+    E.searching = 1;
+    editorFindPoll();
+}
+
+void editorFindClear(void)
+{
+    editorSearchStop();
+    if (E.query)
+    {
+        searchMatcherFree(&E.matcher);
+    }
+    free(E.query);
+    E.query = NULL;
+    regexFree(E.regex);
+    E.regex = NULL;
+    E.regex_error = NULL;
+    E.match_ready = 0;
+    editorDamageAll();
+}
+
+/* A regex that does not compile leaves no query and reports why. */
+void editorFindSet(const char *query)
+{
+    size_t len = strlen(query);
+    const char *error = NULL;
+    Regex *regex = NULL;
+
+    editorFindClear();
+    if (len == 0)
+    {
+        return;
+    }
+    if (E.use_regex)
+    {
+        regex = regexCompile(query, len, &error);
+        if (!regex)
+        {
+            E.regex_error = error;
+            return;
+        }
+    }
+    E.query = malloc(len + 1);
+    memcpy(E.query, query, len + 1);
+    E.regex = regex;
+    searchCompile(&E.pattern, E.query, len, regex);
+    searchMatcherInit(&E.matcher, &E.pattern);
+    if (E.numrows)
+    {
+        editorFindStart(0, 1);
+    }
+}
+
+/*
+ * Moves the cursor to the next (direction > 0) or previous match of the
+ * query, wrapping around. With the index ready this is a rank and a
+ * select on the buffer's tree; otherwise the search is restarted from
+ * the cursor, which also rebuilds the index.
+ */
+void editorFindStep(int direction)
+{
+    SearchPos pos;
+    Erow *row;
+    int total;
+    int k;
+    int nth;
+
+    if (!E.query || !E.numrows)
+    {
+        return;
+    }
+    if (E.cy >= E.numrows)
+    {
+        E.cy = E.numrows - 1;
+        E.cx = 0;
+    }
+    row = bufferGet(&E.buf, E.cy);
+
+    if (!E.match_ready)
+    {
+        nth = editorCountMatches(row->chars, row->size, E.cx + (direction > 0));
+        pos.col = -1;
+        if (direction > 0 || nth > 0)
+        {
+            pos.col = editorRowNthMatch(row, direction > 0 ? nth : nth - 1);
+        }
+        if (pos.col >= 0)
+        {
+            pos.row = E.cy;
+            editorFindShow(pos);
+            return;
+        }
+        editorFindStart(direction > 0 ? E.cy + 1 : E.cy, direction);
+        return;
+    }
+
+    total = bufferMatchRank(&E.buf, E.numrows);
+    if (total == 0)
+    {
+        return;
+    }
+    k = bufferMatchRank(&E.buf, E.cy);
+    if (direction > 0)
+    {
+        k += editorCountMatches(row->chars, row->size, E.cx + 1);
+        if (k == total)
+        {
+            k = 0;
+        }
+    }
+    else
+    {
+        k += editorCountMatches(row->chars, row->size, E.cx) - 1;
+        if (k < 0)
+        {
+            k = total - 1;
+        }
+    }
+    pos.row = bufferMatchSelect(&E.buf, k, &nth);
+    pos.col = editorRowNthMatch(bufferGet(&E.buf, pos.row), nth);
+    editorFindShow(pos);
+}
+
+/*
+ * Loads the first `n` rows if they are not loaded yet, waiting for the
+ * index to find just those lines rather than the whole file.
+ */
+void editorRowsNeeded(int n)
+{
+    int more = n - E.numrows;
+
+    if (E.indexing && more > 0)
+    {
+        lineIndexWaitLines(&E.index, E.indexed + more);
+        editorIngest(more);
+    }
+}
+
+/* Keeps the cursor on a char of its row, or on the first row at all. */
+void editorClampCursor(void)
+{
+    Erow *row;
+
+    if (E.cy >= E.numrows)
+    {
+        E.cy = E.numrows ? E.numrows - 1 : 0;
+    }
+    row = bufferGet(&E.buf, E.cy);
+    if (!row)
+    {
+        E.cx = 0;
+    }
+    else if (E.cx > (row->size ? row->size - 1 : 0))
+    {
+        E.cx = row->size ? row->size - 1 : 0;
+    }
+}
+
+/*
+ * Runs :s over rows cmd->from..cmd->to. The rows are matched and
+ * rewritten on the search pool's threads, then the changed ones are
+ * swapped in here in one walk, recorded as one UNDO_REPLACE_ROWS op, so
+ * a replace across millions of rows is one undo step and one change.
+ */
+static void editorSubstitute(const ExCommand *cmd, const SearchPattern *p)
+{
+    SearchReplace replace;
+    SearchEdits edits;
+    BufferIter it;
+    char *undo;
+    int first;
+    int at;
+    int i;
+
+    editorSearchStop();
+    replace.text = cmd->replace;
+    replace.len = cmd->replace_len;
+    replace.global = cmd->global;
+    searchPoolReplace(
+        &E.search,
+        &E.buf,
+        p,
+        &replace,
+        cmd->from,
+        cmd->to + 1,
+        &edits
+    );
+    if (!edits.count)
+    {
+        free(edits.edits);
+        free(edits.text);
+        editorSetStatusMessage("Pattern not found");
+        return;
+    }
+
+    first = edits.edits[0].row;
+    undo = undoPush(
+        &E.undo,
+        UNDO_REPLACE_ROWS,
+        first,
+        0,
+        edits.count,
+        sizeof(int) * 3 * edits.count + edits.old_bytes + edits.len
+    );
+    bufferIterInit(&E.buf, &it, first);
+    at = first;
+    for (i = 0; i < edits.count; i++)
+    {
+        SearchEdit *edit = &edits.edits[i];
+        Erow *row;
+
+        while (at < edit->row)
+        {
+            bufferIterNext(&it);
+            at++;
+        }
+        row = bufferIterNext(&it);
+        at++;
+        if (undo)
+        {
+            int rec[3];
+            rec[0] = edit->row;
+            rec[1] = row->size;
+            rec[2] = edit->len;
+            memcpy(undo, rec, sizeof(rec));
+            undo += sizeof(rec);
+            memcpy(undo, row->chars, row->size);
+            undo += row->size;
+            memcpy(undo, &edits.text[edit->off], edit->len);
+            undo += edit->len;
+        }
+        editorRowSwap(edit->row, row, &edits.text[edit->off], edit->len);
+    }
+    free(edits.edits);
+    free(edits.text);
+
+    E.dirty++;
+    editorDamageRows(first, -1);
+    if (first < E.hl_valid)
+    {
+        E.hl_valid = first;
+    }
+    E.cy = at - 1;
+    E.cx = 0;
+    editorSetStatusMessage(
+        "%d substitutions on %d lines",
+        edits.subs,
+        edits.count
+    );
+}
+
+/*
+ * Keeps rows at..at + n - 1, which `it` sits just before, for undo as
+ * one deleted run and frees their chars; bufferFilter takes them out of
+ * the tree afterwards. `at` leaves out the runs before this one, since
+ * that is where the run sits when undo and redo replay them in turn.
+ */
+static void editorDropRun(BufferIter *it, int at, int n, size_t len)
+{
+    char *undo = undoPush(&E.undo, UNDO_DELETE_ROWS, at, 0, n, len);
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        Erow *row = bufferIterNext(it);
+        if (undo)
+        {
+            memcpy(undo, row->chars, row->size);
+            undo += row->size;
+            if (i + 1 < n)
+            {
+                *undo++ = '\n';
+            }
+        }
+        editorFreeRow(row);
+    }
+}
+
+/*
+ * Runs :g/pattern/d, or :v and :g! for the rows that do not match, over
+ * rows cmd->from..cmd->to. One scan marks the rows to go and one
+ * bufferFilter pass packs the rest together, so pruning much of a large
+ * file costs a pass over it rather than a delete per row.
+ */
+static void editorGlobal(const ExCommand *cmd, SearchMatcher *m)
+{
+    BufferIter it;
+    BufferIter run;
+    unsigned char *drop;
+    size_t run_len = 0;
+    int run_at = 0;
+    int run_n = 0;
+    int n = cmd->to - cmd->from + 1;
+    int removed = 0;
+    int first = -1;
+    int i;
+
+    editorSearchStop();
+    drop = calloc(n, 1);
+    bufferIterInit(&E.buf, &it, cmd->from);
+    for (i = 0; i <= n; i++)
+    {
+        BufferIter here = it;
+        Erow *row = i < n ? bufferIterNext(&it) : NULL;
+        int hit = 0;
+        int start, end;
+
+        if (row)
+        {
+            searchMatcherRow(m, row->chars, row->size);
+            hit = searchMatchEx(m, 0, -1, &start, &end)
+                      ? !cmd->invert
+                      : cmd->invert;
+        }
+        if (hit)
+        {
+            if (!run_n)
+            {
+                run = here;
+                run_at = cmd->from + i;
+                run_len = 0;
+            }
+            drop[i] = 1;
+            run_n++;
+            run_len += row->size + 1;
+        }
+        else if (run_n)
+        {
+            editorDropRun(&run, run_at - removed, run_n, run_len - 1);
+            if (first < 0)
+            {
+                first = run_at;
+            }
+            removed += run_n;
+            run_n = 0;
+        }
+    }
+
+    if (!removed)
+    {
+        free(drop);
+        editorSetStatusMessage("Pattern not found");
+        return;
+    }
+    bufferFilter(&E.buf, cmd->from, n, drop);
+    free(drop);
+    E.numrows -= removed;
+    E.dirty++;
+    editorDamageRows(first, -1);
+    if (first < E.hl_valid)
+    {
+        E.hl_valid = first;
+    }
+    E.cy = first;
+    E.cx = 0;
+    editorClampCursor();
+    editorSetStatusMessage("%d fewer lines", removed);
+}
+
+/* Runs a command line typed after `:`. */
+void editorExecute(const char *line)
+{
+    ExCommand cmd;
+    const char *error = exParse(line, E.cy, &cmd);
+    SearchPattern pattern;
+    SearchMatcher matcher;
+    Regex *regex;
+
+    if (error)
+    {
+        editorSetStatusMessage("%s", error);
+        return;
+    }
+    if (cmd.from == EX_LAST || cmd.to == EX_LAST)
+    {
+        editorIndexFinish();
+    }
+    else
+    {
+        editorRowsNeeded((cmd.from > cmd.to ? cmd.from : cmd.to) + 1);
+    }
+    if (cmd.from == EX_LAST || cmd.from >= E.numrows)
+    {
+        cmd.from = E.numrows - 1;
+    }
+    if (cmd.to == EX_LAST || cmd.to >= E.numrows)
+    {
+        cmd.to = E.numrows - 1;
+    }
+    if (cmd.from > cmd.to)
+    {
+        int t = cmd.from;
+        cmd.from = cmd.to;
+        cmd.to = t;
+    }
+
+    switch (cmd.type)
+    {
+    case EX_GOTO:
+        E.cy = cmd.to > 0 ? cmd.to : 0;
+        editorClampCursor();
+        break;
+    case EX_WRITE:
+        /* :w name writes a copy, and only names a buffer that has none */
+        if (cmd.arg && !E.filename)
+        {
+            E.filename = cmd.arg;
+            cmd.arg = NULL;
+            editorSelectSyntax();
+        }
+        if (cmd.arg)
+        {
+            editorSaveTo(cmd.arg);
+        }
+        else
+        {
+            editorSave();
+        }
+        break;
+    case EX_QUIT:
+    case EX_WRITE_QUIT:
+        if (cmd.type == EX_WRITE_QUIT)
+        {
+            editorSave();
+        }
+        if (E.dirty && !cmd.force)
+        {
+            editorSetStatusMessage(
+                "No write since last change (add ! to override)"
+            );
+            break;
+        }
+        E.quit = 1;
+        break;
+    case EX_STATS:
+        if (cmd.arg)
+        {
+            editorStatsDump(cmd.arg);
+        }
+        else
+        {
+            E.stats_shown = !E.stats_shown;
+        }
+        break;
+    case EX_SUBSTITUTE:
+    case EX_GLOBAL:
+        if (!E.numrows)
+        {
+            break;
+        }
+        regex = regexCompile(cmd.pattern, cmd.pattern_len, &error);
+        if (!regex)
+        {
+            editorSetStatusMessage("Bad pattern: %s", error);
+            break;
+        }
+        searchCompile(&pattern, cmd.pattern, cmd.pattern_len, regex);
+        if (cmd.type == EX_SUBSTITUTE)
+        {
+            editorSubstitute(&cmd, &pattern);
+        }
+        else
+        {
+            searchMatcherInit(&matcher, &pattern);
+            editorGlobal(&cmd, &matcher);
+            searchMatcherFree(&matcher);
+        }
+        regexFree(regex);
+        break;
+    }
+    exFree(&cmd);
+}
+
+/*
+ * Line `k` of the stats report: a header, a line per timed hot path and
+ * two on memory. Bytes per row count the Erow and the slab blocks of the
+ * rows, not the file mapping that unedited rows point into. Returns 0
+ * past the last line.
+ */
+int editorStatsLine(int k, char *buf, size_t size)
+{
+    if (k == 0)
+    {
+        snprintf(
+            buf,
+            size,
+            "%-11s %9s %10s %8s %8s",
+            "",
+            "calls",
+            "total ms",
+            "avg ms",
+            "max ms"
+        );
+    }
+    else if (k <= STATS)
+    {
+        Stat *s = &stats[k - 1];
+        snprintf(
+            buf,
+            size,
+            "%-11s %9lu %10.1f %8.3f %8.3f",
+            s->name,
+            s->calls,
+            s->ms,
+            s->calls ? s->ms / s->calls : 0.0,
+            s->max
+        );
+    }
+    else if (k == STATS + 1)
+    {
+        snprintf(
+            buf,
+            size,
+            "%d rows, %.1f bytes/row",
+            E.numrows,
+            E.numrows ? (E.slab.live + sizeof(Erow) * (double)E.numrows) /
+                            E.numrows
+                      : 0.0
+        );
+    }
+    else if (k == STATS + 2)
+    {
+        snprintf(
+            buf,
+            size,
+            "%lu allocs, %.1f MB live, %.1f MB render cache",
+            E.slab.allocs,
+            E.slab.live / 1048576.0,
+            E.cache_bytes / 1048576.0
+        );
+    }
+    else
+    {
+        return 0;
+    }
+    return 1;
+}
+
+/* Writes the stats report to `path`; returns -1 if it cannot. */
+int editorStatsDump(const char *path)
+{
+    char line[128];
+    FILE *fp = fopen(path, "w");
+    int k;
+
+    if (!fp)
+    {
+        editorSetStatusMessage("Can't write %s: %s", path, strerror(errno));
+        return -1;
+    }
+    for (k = 0; editorStatsLine(k, line, sizeof(line)); k++)
+    {
+        fprintf(fp, "%s\n", line);
+    }
+    if (fclose(fp) == EOF)
+    {
+        editorSetStatusMessage("Can't write %s: %s", path, strerror(errno));
+        return -1;
+    }
+    editorSetStatusMessage("Stats written to %s", path);
+    return 0;
+}
+
+/*
+ * Ends a frame: while cached renders are over the budget, drops them from
+ * the one drawn longest ago, so a trim costs the renders it evicts. Those
+ * drawn in this frame are kept even if they alone are over the budget.
+ */
+void editorTrimCache(void)
+{
+    while (E.cache_bytes > RENDER_CACHE_BUDGET && E.render_oldest &&
+           E.render_oldest->frame != E.render_frame)
+    {
+        editorRowInvalidate(E.render_oldest->row);
+    }
+    E.render_frame++;
+}
+
+void editorSetStatusMessage(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(E.statusmsg, sizeof(E.statusmsg), fmt, ap);
+    va_end(ap);
+    E.statusmsg_time = time(NULL);
+}
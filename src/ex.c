@@ -0,0 +1,285 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ex.h"
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void exSkipBlanks(const char **s)
+{
+    while (**s == ' ' || **s == '\t')
+    {
+        (*s)++;
+    }
+}
+
+/* Keeps the rest of the line, less surrounding blanks, as the argument. */
+static void exArgument(const char *p, ExCommand *cmd)
+{
+    size_t len;
+
+    exSkipBlanks(&p);
+    len = strlen(p);
+    while (len > 0 && isspace((unsigned char)p[len - 1]))
+    {
+        len--;
+    }
+    if (len)
+    {
+        cmd->arg = malloc(len + 1);
+        memcpy(cmd->arg, p, len);
+        cmd->arg[len] = '\0';
+    }
+}
+
+/* Reads one address into `row`; returns 0 if there is none at `s`. */
+static int exAddress(const char **s, int cur, int *row)
+{
+    const char *p = *s;
+
+    if (isdigit((unsigned char)*p))
+    {
+        int n = 0;
+        while (isdigit((unsigned char)*p))
+        {
+            n = n < INT_MAX / 10 ? n * 10 + (*p - '0') : INT_MAX;
+            p++;
+        }
+        *row = n > 0 ? n - 1 : 0;
+    }
+    else if (*p == '.')
+    {
+        *row = cur;
+        p++;
+    }
+    else if (*p == '$')
+    {
+        *row = EX_LAST;
+        p++;
+    }
+    else
+    {
+        return 0;
+    }
+    *s = p;
+    return 1;
+}
+
+/*
+ * Copies the text up to the next unescaped `delim` into a new string and
+ * leaves `s` past the delimiter. Only the backslash of an escaped
+ * delimiter is dropped; other escapes are left to the regex or to the
+ * replacement.
+ */
+static char *exDelimited(const char **s, int delim, size_t *len)
+{
+    const char *p = *s;
+    char *out = malloc(strlen(p) + 1);
+    size_t n = 0;
+
+    while (*p && *p != delim)
+    {
+        if (*p == '\\' && p[1] == delim)
+        {
+            p++;
+        }
+        else if (*p == '\\' && p[1])
+        {
+            out[n++] = *p++;
+        }
+        out[n++] = *p++;
+    }
+    if (*p == delim)
+    {
+        p++;
+    }
+    out[n] = '\0';
+    *len = n;
+    *s = p;
+    return out;
+}
+
+/* Reads the delimiter that opens the pattern of :s or :g. */
+static int exDelimiter(const char **s)
+{
+    int delim = (unsigned char)**s;
+
+    if (!delim || isalnum(delim) || isspace(delim) || delim == '\\')
+    {
+        return 0;
+    }
+    (*s)++;
+    return delim;
+}
+
+/*
+ * Parses `line` into `cmd`, with `cur` as the cursor row. Returns NULL on
+ * success, else a message saying what is wrong, in which case there is
+ * nothing to free.
+ */
+const char *exParse(const char *line, int cur, ExCommand *cmd)
+{
+    const char *p = line;
+    char name[8];
+    int ranged = 0;
+    int delim;
+    int n = 0;
+
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->from = cur;
+    cmd->to = cur;
+
+    while (*p == ':' || *p == ' ' || *p == '\t')
+    {
+        p++;
+    }
+    if (*p == '%')
+    {
+        cmd->from = 0;
+        cmd->to = EX_LAST;
+        ranged = 1;
+        p++;
+    }
+    else if (exAddress(&p, cur, &cmd->from))
+    {
+        cmd->to = cmd->from;
+        ranged = 1;
+        if (*p == ',')
+        {
+            p++;
+            if (!exAddress(&p, cur, &cmd->to))
+            {
+                return "Invalid range";
+            }
+        }
+    }
+    exSkipBlanks(&p);
+
+    while (isalpha((unsigned char)*p) && n < (int)sizeof(name) - 1)
+    {
+        name[n++] = *p++;
+    }
+    name[n] = '\0';
+
+    if (!n && !*p && ranged)
+    {
+        cmd->type = EX_GOTO;
+        return NULL;
+    }
+    if (!strcmp(name, "w"))
+    {
+        cmd->type = EX_WRITE;
+        if (*p == '!')
+        {
+            p++;
+        }
+        exArgument(p, cmd);
+        return NULL;
+    }
+    if (!strcmp(name, "stats"))
+    {
+        cmd->type = EX_STATS;
+        exArgument(p, cmd);
+        return NULL;
+    }
+    if (!strcmp(name, "q") || !strcmp(name, "wq") || !strcmp(name, "x"))
+    {
+        cmd->type = name[0] == 'q' ? EX_QUIT : EX_WRITE_QUIT;
+        if (*p == '!')
+        {
+            cmd->force = 1;
+            p++;
+        }
+        exSkipBlanks(&p);
+        return *p ? "Trailing characters" : NULL;
+    }
+    if (!strcmp(name, "s"))
+    {
+        cmd->type = EX_SUBSTITUTE;
+        delim = exDelimiter(&p);
+        if (!delim)
+        {
+            return "Usage: :s/pattern/replacement/[g]";
+        }
+        cmd->pattern = exDelimited(&p, delim, &cmd->pattern_len);
+        cmd->replace = exDelimited(&p, delim, &cmd->replace_len);
+        while (*p == 'g' || *p == ' ')
+        {
+            cmd->global |= *p == 'g';
+            p++;
+        }
+    }
+    else if (!strcmp(name, "g") || !strcmp(name, "v"))
+    {
+        cmd->type = EX_GLOBAL;
+        cmd->invert = name[0] == 'v';
+        if (name[0] == 'g' && *p == '!')
+        {
+            cmd->invert = 1;
+            p++;
+        }
+        if (!ranged)
+        {
+            cmd->from = 0;
+            cmd->to = EX_LAST;
+        }
+        delim = exDelimiter(&p);
+        if (!delim)
+        {
+            return "Usage: :g/pattern/d";
+        }
+        cmd->pattern = exDelimited(&p, delim, &cmd->pattern_len);
+        exSkipBlanks(&p);
+        if (*p != 'd' || (p[1] && strcmp(p, "delete")))
+        {
+            exFree(cmd);
+            return "Only :g/pattern/d is supported";
+        }
+        p = "";
+    }
+    else
+    {
+        return "Not an editor command";
+    }
+
+    if (*p)
+    {
+        exFree(cmd);
+        return "Trailing characters";
+    }
+    if (!cmd->pattern_len)
+    {
+        exFree(cmd);
+        return "Empty pattern";
+    }
+    return NULL;
+}
+
+void exFree(ExCommand *cmd)
+{
+    free(cmd->arg);
+    free(cmd->pattern);
+    free(cmd->replace);
+    cmd->arg = NULL;
+    cmd->pattern = NULL;
+    cmd->replace = NULL;
+}
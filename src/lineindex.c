@@ -0,0 +1,235 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "lineindex.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+/* bytes scanned between two publications of the line count */
+#define LINEINDEX_BLOCK (1 << 20)
+
+#define ONES ((unsigned long)-1 / 0xff)
+#define HIGHS (ONES * 0x80)
+
+static void lineIndexPush(LineIndex *idx, int *count, size_t offset)
+{
+    int chunk = *count / LINEINDEX_CHUNK;
+    if (!idx->chunks[chunk])
+    {
+        idx->chunks[chunk] = malloc(sizeof(size_t) * LINEINDEX_CHUNK);
+    }
+    idx->chunks[chunk][*count % LINEINDEX_CHUNK] = offset;
+    (*count)++;
+}
+
+/*
+ * Records the start of every line that begins in [from, to). Sixteen
+ * bytes are compared at a time with SSE2 where available, otherwise a
+ * machine word at a time; both only fall back to single bytes around
+ * an actual newline.
+ */
+static void lineIndexScan(LineIndex *idx, int *count, size_t from, size_t to)
+{
+    const char *data = idx->data;
+    size_t i = from;
+
+#ifdef __SSE2__
+    __m128i nl = _mm_set1_epi8('\n');
+    for (; i + 16 <= to; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+        while (mask)
+        {
+            size_t pos = i + __builtin_ctz(mask);
+            if (pos + 1 < idx->size)
+            {
+                lineIndexPush(idx, count, pos + 1);
+            }
+            mask &= mask - 1;
+        }
+    }
+#else
+    for (; i < to && (size_t)(data + i) % sizeof(unsigned long); i++)
+    {
+        if (data[i] == '\n' && i + 1 < idx->size)
+        {
+            lineIndexPush(idx, count, i + 1);
+        }
+    }
+    for (; i + sizeof(unsigned long) <= to; i += sizeof(unsigned long))
+    {
+        unsigned long v = *(const unsigned long *)(data + i) ^ (ONES * '\n');
+        if ((v - ONES) & ~v & HIGHS)
+        {
+            size_t j;
+            for (j = i; j < i + sizeof(unsigned long); j++)
+            {
+                if (data[j] == '\n' && j + 1 < idx->size)
+                {
+                    lineIndexPush(idx, count, j + 1);
+                }
+            }
+        }
+    }
+#endif
+
+    for (; i < to; i++)
+    {
+        if (data[i] == '\n' && i + 1 < idx->size)
+        {
+            lineIndexPush(idx, count, i + 1);
+        }
+    }
+}
+
+static void lineIndexPublish(LineIndex *idx, int count, int done)
+{
+    pthread_mutex_lock(&idx->lock);
+    __atomic_store_n(&idx->count, count, __ATOMIC_RELEASE);
+    __atomic_store_n(&idx->done, done, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&idx->grown);
+    pthread_mutex_unlock(&idx->lock);
+}
+
+static void *lineIndexRun(void *arg)
+{
+    LineIndex *idx = arg;
+    int count = 0;
+    size_t from;
+
+    lineIndexPush(idx, &count, 0);
+    for (from = 0; from < idx->size; from += LINEINDEX_BLOCK)
+    {
+        size_t to = from + LINEINDEX_BLOCK;
+        if (__atomic_load_n(&idx->cancel, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+        if (to > idx->size)
+        {
+            to = idx->size;
+        }
+        lineIndexScan(idx, &count, from, to);
+        lineIndexPublish(idx, count, 0);
+    }
+    lineIndexPublish(idx, count, 1);
+    return NULL;
+}
+
+void lineIndexStart(LineIndex *idx, const char *data, size_t size)
+{
+    idx->data = data;
+    idx->size = size;
+    idx->nchunks = (size + 1) / LINEINDEX_CHUNK + 1;
+    idx->chunks = calloc(idx->nchunks, sizeof(size_t *));
+    idx->count = 0;
+    idx->done = 0;
+    idx->cancel = 0;
+    pthread_mutex_init(&idx->lock, NULL);
+    pthread_cond_init(&idx->grown, NULL);
+    idx->running = pthread_create(&idx->thread, NULL, lineIndexRun, idx) == 0;
+    if (!idx->running)
+    {
+        lineIndexRun(idx);
+    }
+}
+
+/*
+ * Number of lines whose extent is known. The last line found is only
+ * complete once the scan has passed its end, i.e. when it finished.
+ */
+int lineIndexLines(LineIndex *idx, int *done)
+{
+    int d = __atomic_load_n(&idx->done, __ATOMIC_ACQUIRE);
+    int count = __atomic_load_n(&idx->count, __ATOMIC_ACQUIRE);
+    if (done)
+    {
+        *done = d;
+    }
+    return d || count == 0 ? count : count - 1;
+}
+
+void lineIndexLine(LineIndex *idx, int line, const char **start, size_t *len)
+{
+    size_t from = idx->chunks[line / LINEINDEX_CHUNK][line % LINEINDEX_CHUNK];
+    size_t to;
+    if (line + 1 < __atomic_load_n(&idx->count, __ATOMIC_ACQUIRE))
+    {
+        to = idx->chunks[(line + 1) / LINEINDEX_CHUNK]
+                        [(line + 1) % LINEINDEX_CHUNK] -
+             1;
+    }
+    else
+    {
+        to = idx->size;
+        if (to > from && idx->data[to - 1] == '\n')
+        {
+            to--;
+        }
+    }
+    *start = idx->data + from;
+    *len = to - from;
+}
+
+void lineIndexWait(LineIndex *idx)
+{
+    if (idx->running)
+    {
+        pthread_join(idx->thread, NULL);
+        idx->running = 0;
+    }
+}
+
+/* Blocks until at least `lines` lines are known or the scan is over. */
+void lineIndexWaitLines(LineIndex *idx, int lines)
+{
+    int done;
+
+    pthread_mutex_lock(&idx->lock);
+    while (lineIndexLines(idx, &done) < lines && !done)
+    {
+        pthread_cond_wait(&idx->grown, &idx->lock);
+    }
+    pthread_mutex_unlock(&idx->lock);
+}
+
+void lineIndexFree(LineIndex *idx)
+{
+    int i;
+    __atomic_store_n(&idx->cancel, 1, __ATOMIC_RELAXED);
+    lineIndexWait(idx);
+    for (i = 0; i < idx->nchunks; i++)
+    {
+        free(idx->chunks[i]);
+    }
+    if (idx->chunks)
+    {
+        pthread_mutex_destroy(&idx->lock);
+        pthread_cond_destroy(&idx->grown);
+    }
+    free(idx->chunks);
+    idx->chunks = NULL;
+    idx->nchunks = 0;
+}
@@ -22,502 +22,220 @@
 #define _GNU_SOURCE
 
 #include <ctype.h>
-#include <errno.h>
 #include <ncurses.h>
-#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
+
+#include "editor.h"
+#include "keys.h"
+#include "replay.h"
 
 #define CTRL_KEY(k) ((k) & 0x1f)
 #define VERSION "0.1"
-#define TABSTOP 2
+#define INGEST_SLICE 262144
+#define INDEX_POLL 20
+#define COUNT_MAX 99999999
+#define STATUS_TIMEOUT 5
+#define FRAME_INTERVAL 100
+#define PASTE_TIMEOUT 1000
+#define PASTE_ON "\x1b[?2004h"
+#define PASTE_OFF "\x1b[?2004l"
 
-void editorSetStatusMessage(const char *fmt, ...);
 void editorRefreshScreen(void);
 char *editorPrompt(char *prompt, void (*callback)(char *, int));
-void editorInsertRow(int at, char *s, size_t len);
-
-enum EditorHiglightType
-{
-    HL_NORMAL,
-    HL_MATCH,
-    HL_SELECT = 1 << 7
-};
 
-typedef struct
-{
-    int size;
-    int rsize;
-    char *chars;
-    char *render;
-    unsigned char *hl;
-} Erow;
+/* set while --replay feeds keys from a log instead of the terminal */
+static Replay replay;
+static int replaying;
 
+/* what an operator covers when it is given a motion */
 typedef enum
 {
-    NORMAL,
-    INSERT,
-    VISUAL_CHAR
-} Mode;
-
-typedef struct
-{
-    int cx, cy;
-    int rx;
-    int rowoff;
-    int coloff;
-    int screenrows;
-    int numrows;
-    Erow *row;
-    int dirty;
-    char *filename;
-    char statusmsg[80];
-    time_t statusmsg_time;
-    Mode mode;
-    int selection_x, selection_y;
-    int buffer_size;
-    char *copy_buffer;
-} Editor;
-
-Editor E;
-
-void die(const char *s)
-{
-    perror(s);
-    exit(1);
-}
-
-void editorUpdateSyntax(Erow *row)
-{
-    int i;
-
-    row->hl = realloc(row->hl, row->rsize);
-    memset(row->hl, HL_NORMAL, row->rsize);
-
-    for (i = 0; i < row->rsize; i++)
-    {
-    }
-}
-
-int editorRowCxToRx(Erow *row, int cx)
-{
-    int rx = 0;
-    int j;
-    for (j = 0; j < cx; j++)
-    {
-        if (row->chars[j] == '\t')
-        {
-            rx += (TABSTOP - 1) - (rx % TABSTOP);
-        }
-        rx++;
-    }
-    return rx;
-}
-
-int editorRowRxToCx(Erow *row, int rx)
-{
-    int cur_rx = 0;
-    int cx;
-    for (cx = 0; cx < row->size; cx++)
-    {
-        if (row->chars[cx] == '\t')
-        {
-            cur_rx += (TABSTOP - 1) - (cur_rx % TABSTOP);
-        }
-        cur_rx++;
-        if (cur_rx > rx)
-        {
-            return cx;
-        }
-    }
-    return cx;
-}
-
-void editorUpdateRow(Erow *row)
-{
-    int tabs = 0;
-    int j;
-    int idx;
-    for (j = 0; j < row->size; j++)
-    {
-        if (row->chars[j] == '\t')
-        {
-            tabs++;
-        }
-    }
-    free(row->render);
-    row->render = malloc(row->size + tabs * (TABSTOP - 1) + 1);
-    idx = 0;
-    for (j = 0; j < row->size; j++)
-    {
-        if (row->chars[j] == '\t')
-        {
-            row->render[idx++] = ' ';
-            while (idx % TABSTOP != 0)
-            {
-                row->render[idx++] = ' ';
-            }
-        }
-        else
-        {
-            row->render[idx++] = row->chars[j];
-        }
-    }
-    row->render[idx] = '\0';
-    row->rsize = idx;
-
-    editorUpdateSyntax(row);
-}
-
-void editorRowInsertChar(Erow *row, int at, int c)
-{
-    if (at < 0 || at > row->size)
-    {
-        at = row->size;
-    }
-    row->chars = realloc(row->chars, row->size + 2);
-    memmove(&row->chars[at + 1], &row->chars[at], row->size - at + 1);
-    row->size++;
-    row->chars[at] = c;
-    editorUpdateRow(row);
-    E.dirty++;
-}
-
-void editorRowAppendString(Erow *row, char *s, size_t len)
-{
-    row->chars = realloc(row->chars, row->size + len + 1);
-    memcpy(&row->chars[row->size], s, len);
-    row->size += len;
-    row->chars[row->size] = '\0';
-    editorUpdateRow(row);
-    E.dirty++;
-}
-
-void editorRowDelChar(Erow *row, int at)
-{
-    if (at < 0 || at >= row->size)
-    {
-        return;
-    }
-    memmove(&row->chars[at], &row->chars[at + 1], row->size - at);
-    row->size--;
-    editorUpdateRow(row);
-    E.dirty++;
-}
-
-void editorInsertChar(int c)
+    MOTION_NONE,
+    MOTION_CHAR,
+    MOTION_LINE
+} Motion;
+
+/*
+ * Typing at the prompt starts a new search, the arrows step through the
+ * matches, Enter keeps the query highlighted and Escape drops it. Ctrl-R
+ * switches between literal and regex queries. Key ERR is the prompt
+ * polling for the search pool's progress.
+ */
+void editorFindCallback(char *query, int key)
 {
-    if (E.cy == E.numrows)
-    {
-        editorInsertRow(E.numrows, "", 0);
-    }
-    editorRowInsertChar(&E.row[E.cy], E.cx, c);
-    E.cx++;
-}
+    double start = statsNow();
 
-void editorInsertRow(int at, char *s, size_t len)
-{
-    if (at < 0 || at > E.numrows)
+    switch (key)
     {
-        return;
+    case ERR:
+        editorFindPoll();
+        break;
+    case '\r':
+        break;
+    case '\x1b':
+        editorFindClear();
+        break;
+    case CTRL_KEY('r'):
+        E.use_regex = !E.use_regex;
+        editorFindSet(query);
+        break;
+    case KEY_RIGHT:
+    case KEY_DOWN:
+        editorFindStep(1);
+        break;
+    case KEY_LEFT:
+    case KEY_UP:
+        editorFindStep(-1);
+        break;
+    default:
+        editorFindSet(query);
+        break;
     }
-
-    E.row = realloc(E.row, sizeof(Erow) * (E.numrows + 1));
-    memmove(&E.row[at + 1], &E.row[at], sizeof(Erow) * (E.numrows - at));
-    E.row[at].size = len;
-    E.row[at].chars = malloc(len + 1);
-    memcpy(E.row[at].chars, s, len);
-    E.row[at].chars[len] = '\0';
-    E.row[at].rsize = 0;
-    E.row[at].render = NULL;
-    E.row[at].hl = NULL;
-    editorUpdateRow(&E.row[at]);
-
-    E.numrows++;
-    E.dirty++;
+    statsAdd(STAT_FIND, start);
 }
 
-void editorFreeRow(Erow *row)
-{
-    free(row->render);
-    free(row->chars);
-    free(row->hl);
-}
-void editorDelRow(int at)
+void editorFind(void)
 {
-    if (at < 0 || at >= E.numrows)
-    {
-        return;
-    }
-    editorFreeRow(&E.row[at]);
-    memmove(&E.row[at], &E.row[at + 1], sizeof(Erow) * (E.numrows - at - 1));
-    E.numrows--;
-    E.dirty++;
-}
+    int saved_cx = E.cx;
+    int saved_cy = E.cy;
+    int saved_coloff = E.coloff;
+    int saved_rowoff = E.rowoff;
+    char *query;
 
-void editorDelChar(void)
-{
-    Erow *row;
+    editorIndexFinish();
+    query = editorPrompt("/%s", editorFindCallback);
 
-    if (E.cy == E.numrows)
-    {
-        return;
-    }
-    if (E.cx == 0 && E.cy == 0)
-    {
-        return;
-    }
-    row = &E.row[E.cy];
-    if (E.cx > 0)
+    if (query)
     {
-        editorRowDelChar(row, E.cx - 1);
-        E.cx--;
+        free(query);
     }
     else
     {
-        E.cx = E.row[E.cy].size ? E.row[E.cy].size - 1 : 0;
-        editorRowAppendString(&E.row[E.cy - 1], row->chars, row->size);
-        editorDelRow(E.cy);
-        E.cy--;
+        E.cx = saved_cx;
+        E.cy = saved_cy;
+        E.coloff = saved_coloff;
+        E.rowoff = saved_rowoff;
     }
 }
 
-void editorInsertNewline(void)
+/*
+ * A replay draws to a curses screen on /dev/null, sized by $LINES and
+ * $COLUMNS or the terminal's defaults, so it needs no terminal to run.
+ */
+void init(void)
 {
-    if (E.cx == 0)
+    if (replaying)
     {
-        editorInsertRow(E.cy, "", 0);
+        const char *term = getenv("TERM");
+        FILE *out = fopen("/dev/null", "w");
+        if (!out || !newterm(term && *term ? term : "xterm", out, stdin))
+        {
+            fprintf(stderr, "ocean: cannot set up a screen for the replay\n");
+            exit(1);
+        }
     }
     else
     {
-        Erow *row = &E.row[E.cy];
-        editorInsertRow(E.cy + 1, &row->chars[E.cx], row->size - E.cx);
-        row = &E.row[E.cy];
-        row->size = E.cx;
-        row->chars[row->size] = '\0';
-        editorUpdateRow(row);
+        initscr();
     }
-    E.cy++;
-    E.cx = 0;
-}
-
-char *editorRowsToString(unsigned int *buflen)
-{
-    char *buf;
-    char *p;
-    int totlen = 0;
-    int j;
-    for (j = 0; j < E.numrows; j++)
-    {
-        totlen += E.row[j].size + 1;
-    }
-    *buflen = totlen;
-    buf = malloc(totlen);
-    p = buf;
-    for (j = 0; j < E.numrows; j++)
+    start_color();
+    noecho();
+    raw();
+    nonl();
+    keypad(stdscr, TRUE);
+    idlok(stdscr, TRUE);
+    timeout(300);
+    ESCDELAY = 10;
+    define_key("\x1b[200~", KEY_PASTE);
+    define_key("\x1b[201~", KEY_PASTE_END);
+    if (!replaying)
     {
-        memcpy(p, E.row[j].chars, E.row[j].size);
-        p += E.row[j].size;
-        *p = '\n';
-        p++;
+        fputs(PASTE_ON, stdout);
+        fflush(stdout);
     }
-    return buf;
+
+    /* setup color pairs */
+    use_default_colors();
+    init_pair(HL_SELECT, COLOR_BLACK, COLOR_WHITE);
+    init_pair(HL_MATCH, COLOR_WHITE, COLOR_BLUE);
+    init_pair(HL_COMMENT, COLOR_CYAN, -1);
+    init_pair(HL_MLCOMMENT, COLOR_CYAN, -1);
+    init_pair(HL_KEYWORD1, COLOR_YELLOW, -1);
+    init_pair(HL_KEYWORD2, COLOR_GREEN, -1);
+    init_pair(HL_STRING, COLOR_MAGENTA, -1);
+    init_pair(HL_NUMBER, COLOR_RED, -1);
+
+    editorInit(LINES - 2);
+    E.drawn_cols = COLS;
 }
 
-void editorOpen(char *filename)
+/*
+ * The next key, or ERR if none comes within `delay` ms. A replay hands
+ * out the keys of its log at once and quits when it runs out, answering
+ * Escape meanwhile so any prompt or pending command unwinds.
+ */
+int editorReadKey(int delay)
 {
-    FILE *fp = fopen(filename, "r");
-    char *line = NULL;
-    size_t linecap = 0;
-    ssize_t linelen;
-    free(E.filename);
-    E.filename = strdup(filename);
-
-    if (!fp)
-    {
-        die("fopen");
-    }
-
-    while ((linelen = getline(&line, &linecap, fp)) != -1)
+    if (replaying)
     {
-        while (linelen > 0 &&
-               (line[linelen - 1] == '\n' || line[linelen - 1] == '\r'))
+        int c = replayKey(&replay, E.mode);
+        if (c < 0)
         {
-            linelen--;
+            E.quit = 1;
+            return 27;
         }
-        editorInsertRow(E.numrows, line, linelen);
+        return c;
     }
-    free(line);
-    fclose(fp);
-    E.dirty = 0;
+    timeout(delay);
+    return getch();
 }
 
-void editorSave(void)
+/*
+ * How long to wait for a key: short polls while background work is due
+ * to show up, otherwise until the status message expires, otherwise with
+ * no timeout at all, so an idle editor never wakes.
+ */
+static int editorIdleDelay(void)
 {
-    unsigned int len;
-    FILE *fp;
-    char *buf;
+    time_t left;
 
-    if (!E.filename)
-    {
-        E.filename = editorPrompt("Save as %s", NULL);
-        if (!E.filename)
-        {
-            editorSetStatusMessage("Save aborted");
-            return;
-        }
-    }
-
-    buf = editorRowsToString(&len);
-    fp = fopen(E.filename, "w");
-    if (!fp)
-    {
-        die("fopen");
-    }
-    if (fwrite(buf, sizeof(char), len, fp) == len)
+    if (E.indexing || E.counting || E.searching)
     {
-        editorSetStatusMessage("%d bytes written to disk", len);
-        E.dirty = 0;
+        return INDEX_POLL;
     }
-    else
+    left = E.statusmsg_time + STATUS_TIMEOUT - time(NULL);
+    if (E.statusmsg[0] && left > 0)
     {
-        editorSetStatusMessage("Can't save! I/O error: %s", strerror(errno));
+        return left * 1000;
     }
-
-    fclose(fp);
-    free(buf);
+    return -1;
 }
 
-void editorFindCallback(char *query, int key)
+/*
+ * Redraws unless more input is already waiting, as it is for a paste or
+ * a held key, so that a burst of keys is handled before one frame. A
+ * burst that goes on is still drawn every FRAME_INTERVAL ms. A replay
+ * draws after every key, since its keys are timed one by one.
+ */
+void editorUpdateScreen(void)
 {
-    int current;
-    int i;
-    static int last_match = -1;
-    static int direction = 1;
-
-    static int save_hl_line;
-    static char *saved_hl = NULL;
+    static double drawn;
+    int c;
 
-    if (saved_hl)
-    {
-        memcpy(E.row[save_hl_line].hl, saved_hl, E.row[save_hl_line].rsize);
-        free(saved_hl);
-        saved_hl = NULL;
-    }
-
-    if (key == '\r' || key == '\x1b')
-    {
-        last_match = -1;
-        direction = 1;
-        return;
-    }
-    else if (key == KEY_RIGHT || key == KEY_DOWN)
-    {
-        direction = 1;
-    }
-    else if (key == KEY_LEFT || key == KEY_UP)
-    {
-        direction = -1;
-    }
-    else
+    if (!replaying && statsNow() - drawn < FRAME_INTERVAL)
     {
-        last_match = -1;
-        direction = 1;
-    }
-    if (last_match == -1)
-    {
-        direction = 1;
-    }
-    current = last_match;
-    for (i = 0; i < E.numrows; i++)
-    {
-        Erow *row;
-        char *match;
-
-        current += direction;
-        if (current == -1)
-        {
-            current = E.numrows - 1;
-        }
-        else if (current == E.numrows)
-        {
-            current = 0;
-        }
-        row = &E.row[current];
-        match = strstr(row->render, query);
-        if (match)
+        timeout(0);
+        c = getch();
+        if (c != ERR)
         {
-            last_match = current;
-            E.cy = current;
-            E.cx = editorRowRxToCx(row, match - row->render);
-            E.rowoff = E.numrows;
-            saved_hl = malloc(row->rsize);
-            save_hl_line = current;
-            memcpy(saved_hl, row->hl, row->rsize);
-
-            memset(&row->hl[match - row->render], HL_MATCH, strlen(query));
-            break;
+            ungetch(c);
+            return;
         }
     }
-}
-
-void editorFind(void)
-{
-    int saved_cx = E.cx;
-    int saved_cy = E.cy;
-    int saved_coloff = E.coloff;
-    int saved_rowoff = E.rowoff;
-
-    char *query = editorPrompt("/%s", editorFindCallback);
-
-    if (query)
-    {
-        free(query);
-    }
-    else
-    {
-        E.cx = saved_cx;
-        E.cy = saved_cy;
-        E.coloff = saved_coloff;
-        E.rowoff = saved_rowoff;
-    }
-}
-
-void init(void)
-{
-    initscr();
-    start_color();
-    noecho();
-    raw();
-    nonl();
-    keypad(stdscr, TRUE);
-    timeout(300);
-    ESCDELAY = 10;
-
-    /* setup color pairs */
-    init_pair(HL_SELECT, COLOR_BLACK, COLOR_WHITE);
-    init_pair(HL_MATCH, COLOR_WHITE, COLOR_BLUE);
-
-    /* initialize global editor */
-    E.cx = 0;
-    E.cy = 0;
-    E.rx = 0;
-    E.rowoff = 0;
-    E.coloff = 0;
-    E.screenrows = LINES - 2;
-    E.numrows = 0;
-    E.row = NULL;
-    E.dirty = 0;
-    E.filename = NULL;
-    E.statusmsg[0] = '\0';
-    E.statusmsg_time = 0;
-    E.mode = NORMAL;
-    E.selection_x = 0;
-    E.selection_y = 0;
-    E.buffer_size = 80;
-    E.copy_buffer = malloc(E.buffer_size);
-    *E.copy_buffer = '\0';
+    editorRefreshScreen();
+    drawn = statsNow();
 }
 
 char *editorPrompt(char *prompt, void (*callback)(char *, int))
@@ -532,9 +250,10 @@ char *editorPrompt(char *prompt, void (*callback)(char *, int))
         int c;
 
         editorSetStatusMessage(prompt, buf);
-        editorRefreshScreen();
+        editorUpdateScreen();
 
-        c = getch();
+        /* a callback with work in flight is polled with ERR meanwhile */
+        c = editorReadKey(editorIdleDelay());
         if (c == KEY_DC || c == KEY_BACKSPACE || c == CTRL_KEY('h') || c == 127)
         {
             if (buflen != 0)
@@ -544,6 +263,10 @@ char *editorPrompt(char *prompt, void (*callback)(char *, int))
             else
             {
                 editorSetStatusMessage("");
+                if (callback)
+                {
+                    callback(buf, 27);
+                }
                 free(buf);
                 return NULL;
             }
@@ -570,8 +293,12 @@ char *editorPrompt(char *prompt, void (*callback)(char *, int))
                 return buf;
             }
         }
-        else if (c == -1)
+        else if (c == ERR)
         {
+            if (callback)
+            {
+                callback(buf, c);
+            }
             continue;
         }
         else if (!iscntrl(c) && c < 128)
@@ -591,14 +318,30 @@ char *editorPrompt(char *prompt, void (*callback)(char *, int))
     }
 }
 
+/* Saves, asking for a file name first if there is none yet. */
+void editorSavePrompt(void)
+{
+    if (!E.filename)
+    {
+        E.filename = editorPrompt("Save as %s", NULL);
+        if (!E.filename)
+        {
+            editorSetStatusMessage("Save aborted");
+            return;
+        }
+        editorSelectSyntax();
+    }
+    editorSave();
+}
+
 void editorMoveCursor(int key)
 {
-    Erow row;
+    Erow *row;
     if (!E.numrows)
     {
         return;
     }
-    row = E.row[E.cy];
+    row = bufferGet(&E.buf, E.cy);
     switch (key)
     {
     case 'h':
@@ -609,15 +352,16 @@ void editorMoveCursor(int key)
         else if (E.cy > 0)
         {
             E.cy--;
-            E.cx = E.row[E.cy].size ? E.row[E.cy].size - 1 : 0;
+            row = bufferGet(&E.buf, E.cy);
+            E.cx = row->size ? row->size - 1 : 0;
         }
         break;
     case 'l':
-        if (E.cx < (E.row[E.cy].size ? E.row[E.cy].size - 1 : 0))
+        if (row && E.cx < (row->size ? row->size - 1 : 0))
         {
             E.cx++;
         }
-        else if (E.cx == (E.row[E.cy].size ? E.row[E.cy].size - 1 : 0))
+        else if (E.cy < E.numrows - 1)
         {
             E.cy++;
             E.cx = 0;
@@ -632,32 +376,457 @@ void editorMoveCursor(int key)
     case 'j':
         if (E.cy < E.numrows - 1)
         {
-            E.cy++;
+            E.cy++;
+        }
+        break;
+    }
+
+    row = bufferGet(&E.buf, E.cy);
+    if (row && E.cx > (row->size ? row->size - 1 : 0))
+    {
+        E.cx = row->size ? row->size - 1 : 0;
+    }
+}
+
+/* 0 for blanks, 1 for word chars and 2 for anything else */
+static int editorCharClass(int c)
+{
+    if (isspace(c))
+    {
+        return 0;
+    }
+    return isalnum(c) || c == '_' ? 1 : 2;
+}
+
+/* Moves (y, x) to the start of the next word; an empty row is a word. */
+static void editorWordForward(int *y, int *x)
+{
+    Erow *row = bufferGet(&E.buf, *y);
+    int cls = 0;
+
+    if (*x < row->size)
+    {
+        cls = editorCharClass((unsigned char)row->chars[*x]);
+    }
+    while (cls && *x < row->size &&
+           editorCharClass((unsigned char)row->chars[*x]) == cls)
+    {
+        (*x)++;
+    }
+    while (1)
+    {
+        while (*x < row->size && isspace((unsigned char)row->chars[*x]))
+        {
+            (*x)++;
+        }
+        if (*x < row->size || *y + 1 >= E.numrows)
+        {
+            return;
+        }
+        (*y)++;
+        *x = 0;
+        row = bufferGet(&E.buf, *y);
+        if (row->size == 0)
+        {
+            return;
+        }
+    }
+}
+
+/* Moves (y, x) to the start of the word before it. */
+static void editorWordBackward(int *y, int *x)
+{
+    Erow *row = bufferGet(&E.buf, *y);
+    int cls;
+
+    while (1)
+    {
+        (*x)--;
+        while (*x >= 0 && isspace((unsigned char)row->chars[*x]))
+        {
+            (*x)--;
+        }
+        if (*x >= 0)
+        {
+            break;
+        }
+        if (*y == 0)
+        {
+            *x = 0;
+            return;
+        }
+        (*y)--;
+        row = bufferGet(&E.buf, *y);
+        *x = row->size;
+        if (row->size == 0)
+        {
+            return;
+        }
+    }
+    cls = editorCharClass((unsigned char)row->chars[*x]);
+    while (*x > 0 &&
+           editorCharClass((unsigned char)row->chars[*x - 1]) == cls)
+    {
+        (*x)--;
+    }
+}
+
+
+/*
+ * Moves (y, x) by motion `c` repeated `count` times, 0 meaning no count
+ * was typed, in one jump rather than `count` steps; 'g' stands for gg.
+ * Returns how an operator treats the motion, or MOTION_NONE if `c` is
+ * not one. Charwise motions are exclusive: an operator over one stops
+ * short of where it lands.
+ */
+static Motion editorMotion(int c, int count, int *y, int *x)
+{
+    int n = count ? count : 1;
+    int i;
+
+    if (!E.numrows)
+    {
+        return MOTION_NONE;
+    }
+    switch (c)
+    {
+    case 'h':
+        *x = *x > n ? *x - n : 0;
+        return MOTION_CHAR;
+    case 'l':
+        *x = bufferGet(&E.buf, *y)->size - *x > n
+                 ? *x + n
+                 : bufferGet(&E.buf, *y)->size;
+        return MOTION_CHAR;
+    case '0':
+        *x = 0;
+        return MOTION_CHAR;
+    case '$':
+        editorRowsNeeded(*y + n);
+        *y = E.numrows - *y > n ? *y + n - 1 : E.numrows - 1;
+        *x = bufferGet(&E.buf, *y)->size;
+        return MOTION_CHAR;
+    case 'w':
+        for (i = 0; i < n; i++)
+        {
+            editorWordForward(y, x);
+        }
+        return MOTION_CHAR;
+    case 'b':
+        for (i = 0; i < n; i++)
+        {
+            editorWordBackward(y, x);
+        }
+        return MOTION_CHAR;
+    case 'j':
+        editorRowsNeeded(*y + n + 1);
+        *y = E.numrows - 1 - *y > n ? *y + n : E.numrows - 1;
+        return MOTION_LINE;
+    case 'k':
+        *y = *y > n ? *y - n : 0;
+        return MOTION_LINE;
+    case 'G':
+        /* only a bare G has to wait for the end of the file */
+        if (count)
+        {
+            editorRowsNeeded(count);
+        }
+        else
+        {
+            editorIndexFinish();
+        }
+        *y = count && count < E.numrows ? count - 1 : E.numrows - 1;
+        return MOTION_LINE;
+    case 'g':
+        editorRowsNeeded(count);
+        *y = count && count < E.numrows ? count - 1 : 0;
+        return MOTION_LINE;
+    }
+    return MOTION_NONE;
+}
+
+
+/*
+ * Runs operator d, y, c, > or < over rows fy..ty with `linewise` set,
+ * else over the text from (fy, fx) up to but not including (ty, tx).
+ * However large the range, that is one register store and a bulk edit
+ * or two.
+ */
+static void editorOperate(
+    int op,
+    int linewise,
+    int fy,
+    int fx,
+    int ty,
+    int tx
+)
+{
+    int n = ty - fy + 1;
+
+    if (op == '>' || op == '<')
+    {
+        /* a charwise range ending at column 0 leaves its last row alone */
+        int last = !linewise && ty > fy && tx == 0 ? ty - 1 : ty;
+        editorShiftRows(fy, last, op == '>' ? 1 : -1);
+        fx = 0;
+    }
+    else if (linewise)
+    {
+        editorYankRows(fy, n);
+        if (op == 'd')
+        {
+            editorDelRows(fy, n);
+        }
+        else if (op == 'c')
+        {
+            Erow *row;
+            editorDelRows(fy + 1, n - 1);
+            row = bufferGet(&E.buf, fy);
+            if (row->size > 0)
+            {
+                editorDeleteText(fy, 0, row->size);
+            }
+        }
+        fx = op == 'y' ? E.cx : 0;
+    }
+    else
+    {
+        size_t len;
+        char *text = editorRangeText(fy, fx, ty, tx, &len);
+        editorRegisterStore(text, len, 0);
+        if (op != 'y')
+        {
+            editorDeleteRange(fy, fx, ty, tx);
+        }
+    }
+
+    E.cy = fy;
+    E.cx = fx;
+    if (op == 'c')
+    {
+        E.mode = INSERT;
+        return;
+    }
+    editorClampCursor();
+}
+
+/*
+ * Finishes operator `op` with the key typed after it: the operator again
+ * for whole rows (dd, 3yy), otherwise a motion over the range to cover.
+ */
+static void editorOperator(int op, int c, int count)
+{
+    int n = count ? count : 1;
+    int fy = E.cy;
+    int fx = E.cx;
+    int ty = E.cy;
+    int tx = E.cx;
+    Motion motion;
+
+    if (c == op)
+    {
+        editorRowsNeeded(E.cy + n);
+        ty = E.numrows - E.cy > n ? E.cy + n - 1 : E.numrows - 1;
+        editorOperate(op, 1, fy, 0, ty, 0);
+        return;
+    }
+    motion = editorMotion(c, count, &ty, &tx);
+    if (motion == MOTION_NONE)
+    {
+        return;
+    }
+    if (ty < fy || (ty == fy && tx < fx))
+    {
+        int y = fy;
+        int x = fx;
+        fy = ty;
+        fx = tx;
+        ty = y;
+        tx = x;
+    }
+    if (motion == MOTION_CHAR && ty > fy && tx == 0)
+    {
+        /* as in vi, dw on the last word of a row keeps the newline */
+        ty--;
+        tx = bufferGet(&E.buf, ty)->size;
+    }
+    if (op == 'c' && c == 'w')
+    {
+        /* cw changes words but not the blanks after them */
+        Erow *row = bufferGet(&E.buf, ty);
+        while (tx > 0 && (ty > fy || tx > fx + 1) &&
+               isspace((unsigned char)row->chars[tx - 1]))
+        {
+            tx--;
+        }
+    }
+    if (motion == MOTION_CHAR && fy == ty && fx == tx)
+    {
+        return;
+    }
+    editorOperate(op, motion == MOTION_LINE, fy, fx, ty, tx);
+}
+
+/* Moves the cursor by motion `c`, see editorMotion. */
+static void editorMoveMotion(int c, int count)
+{
+    int y = E.cy;
+    int x = E.cx;
+
+    if (!count && (c == 'h' || c == 'l'))
+    {
+        editorMoveCursor(c);
+        return;
+    }
+    if (editorMotion(c, count, &y, &x) != MOTION_NONE)
+    {
+        E.cy = y;
+        E.cx = x;
+        editorClampCursor();
+    }
+}
+
+/* Drops a half typed command. */
+static void editorNormalReset(void)
+{
+    E.count = 0;
+    E.op = 0;
+    E.opcount = 0;
+    E.pending = 0;
+    E.reg = 0;
+}
+
+/*
+ * Reads a bracketed paste up to its end marker and puts it in as text
+ * in one piece, so none of it passes through the key handlers, the jk
+ * chord or tab expansion. Keys that curses decoded inside the paste are
+ * dropped. A paste whose end marker never comes ends once no input has
+ * arrived for PASTE_TIMEOUT ms. A pending command or a selection is
+ * given up.
+ */
+static void editorReadPaste(void)
+{
+    size_t cap = 4096;
+    size_t len = 0;
+    char *text = malloc(cap);
+    int c;
+
+    while (!E.quit && (c = editorReadKey(PASTE_TIMEOUT)) != ERR &&
+           c != KEY_PASTE_END)
+    {
+        if (c > 0xff)
+        {
+            continue;
+        }
+        if (len == cap)
+        {
+            cap *= 2;
+            text = realloc(text, cap);
+        }
+        text[len++] = c;
+    }
+    if (E.mode == VISUAL_CHAR)
+    {
+        E.mode = NORMAL;
+    }
+    editorNormalReset();
+    editorPasteText(text, len);
+    free(text);
+}
+
+/*
+ * Normal mode reads a command a key at a time, as ["x][count] followed
+ * by a command, or by an operator, another count and a motion, so no key
+ * blocks waiting for the next. A count is handed to the command, which
+ * acts on it in one go instead of running `count` times.
+ */
+void editorProcessKeypressNormal(int c)
+{
+    int count;
+
+    /* a resize is picked up by the next redraw and leaves a command be */
+    if (c == ERR || c == KEY_RESIZE)
+    {
+        return;
+    }
+    if (E.pending == '"')
+    {
+        E.pending = 0;
+        if (c >= 'a' && c <= 'z')
+        {
+            E.reg = c - 'a' + 1;
+        }
+        else
+        {
+            editorNormalReset();
         }
-        break;
+        return;
+    }
+    if (!E.pending && isdigit(c) && (c != '0' || E.count))
+    {
+        E.count = E.count < COUNT_MAX / 10 ? E.count * 10 + c - '0'
+                                           : COUNT_MAX;
+        return;
+    }
+    if (E.pending == 'g')
+    {
+        E.pending = 0;
+        if (c != 'g')
+        {
+            editorNormalReset();
+            return;
+        }
+    }
+    else if (c == 'g' || (c == '"' && !E.op))
+    {
+        E.pending = c;
+        return;
     }
 
-    row = E.row[E.cy];
-    if (E.cx > (row.size ? row.size - 1 : 0))
+    /* an operator count and a motion count multiply, as in 2d3w */
+    count = E.count;
+    if (E.opcount)
     {
-        E.cx = row.size ? row.size - 1 : 0;
+        count = E.count ? E.count : 1;
+        count = count < COUNT_MAX / E.opcount ? count * E.opcount
+                                              : COUNT_MAX;
+    }
+    if (E.op)
+    {
+        editorOperator(E.op, c, count);
+        editorNormalReset();
+        return;
     }
-}
 
-void editorProcessKeypressNormal(int c)
-{
     switch (c)
     {
     case 'h':
     case 'j':
     case 'k':
     case 'l':
-        editorMoveCursor(c);
+    case 'w':
+    case 'b':
+    case '0':
+    case '$':
+    case 'G':
+    case 'g':
+        editorMoveMotion(c, count);
+        break;
+    case 'd':
+    case 'y':
+    case 'c':
+    case '>':
+    case '<':
+        if (E.numrows)
+        {
+            E.op = c;
+            E.opcount = E.count;
+            E.count = 0;
+            return;
+        }
         break;
     case 'q':
-        clear();
-        endwin();
-        exit(0);
+        E.quit = 1;
         break;
     case 'i':
         E.mode = INSERT;
@@ -672,7 +841,7 @@ void editorProcessKeypressNormal(int c)
     case 'A':
         if (E.numrows)
         {
-            E.cx = E.row[E.cy].size;
+            E.cx = bufferGet(&E.buf, E.cy)->size;
         }
         E.mode = INSERT;
         break;
@@ -692,72 +861,84 @@ void editorProcessKeypressNormal(int c)
             break;
         }
         editorInsertRow(E.cy, "", 0);
-        E.cy = E.cy ? E.cy-- : 0;
         E.cx = 0;
         E.mode = INSERT;
         break;
     case 'x':
+    {
+        Erow *row;
+        int n = count ? count : 1;
+        char *text;
+
         if (!E.numrows)
         {
             break;
         }
-
-        E.copy_buffer[0] = E.row[E.cy].chars[E.cx];
-        E.copy_buffer[1] = '\0';
-        E.cx++;
-
-        editorSetStatusMessage("Copied %c", E.copy_buffer[0]);
-
-        editorDelChar();
-        break;
-    case 'd':
-    {
-        Erow row;
-        int c2 = getch();
-        if (c2 == 'd')
+        row = bufferGet(&E.buf, E.cy);
+        if (E.cx >= row->size)
         {
-            if (E.numrows == 0)
-            {
-                break;
-            }
-            editorDelRow(E.cy);
-            if (E.numrows != 0)
-            {
-                row = E.row[E.cy];
-                if (E.cx > (row.size ? row.size - 1 : 0))
-                {
-                    E.cx = row.size ? row.size - 1 : 0;
-                }
-            }
-            else
-            {
-                E.cx = 0;
-            }
-            editorRefreshScreen();
+            break;
         }
-        else
+        if (n > row->size - E.cx)
+        {
+            n = row->size - E.cx;
+        }
+        text = malloc(n);
+        memcpy(text, &row->chars[E.cx], n);
+        editorRegisterStore(text, n, 0);
+        if (n == 1)
         {
-            editorProcessKeypressNormal(c2);
+            editorSetStatusMessage("Copied %c", text[0]);
         }
+        editorDeleteText(E.cy, E.cx, n);
+        editorClampCursor();
+        break;
     }
-    break;
     case '/':
         editorFind();
         break;
-    case 'v':
-        E.mode = VISUAL_CHAR;
-        E.selection_x = E.cx;
-        E.selection_y = E.cy;
+    case ':':
+    {
+        char *line = editorPrompt(":%s", NULL);
+        if (line)
+        {
+            editorExecute(line);
+            free(line);
+        }
         break;
-    case 'p':
+    }
+    case 'n':
+        editorFindStep(1);
+        break;
+    case 'N':
+        editorFindStep(-1);
+        break;
+    case 'u':
+    case CTRL_KEY('r'):
     {
         int i;
-        for (i = 0; E.copy_buffer[i] != '\0'; i++)
+        for (i = 0; i < (count ? count : 1); i++)
         {
-            editorInsertChar(E.copy_buffer[i]);
+            if (!editorUndo(c == 'u' ? -1 : 1))
+            {
+                break;
+            }
         }
+        break;
     }
+    case 'v':
+        E.mode = VISUAL_CHAR;
+        E.selection_x = E.cx;
+        E.selection_y = E.cy;
+        break;
+    case 'p':
+        editorPaste(1, count ? count : 1);
+        break;
+    case 'P':
+        editorPaste(0, count ? count : 1);
+        break;
     }
+    editorNormalReset();
 }
 
 void editorProcessKeypressInsert(int c)
@@ -765,9 +946,7 @@ void editorProcessKeypressInsert(int c)
     switch (c)
     {
     case CTRL_KEY('q'):
-        clear();
-        endwin();
-        exit(0);
+        E.quit = 1;
         break;
     case KEY_NPAGE:
     case KEY_PPAGE:
@@ -788,22 +967,24 @@ void editorProcessKeypressInsert(int c)
         times = E.screenrows;
         while (times--)
         {
-            c == KEY_PPAGE ? editorMoveCursor(KEY_UP) :
-                             editorMoveCursor(KEY_DOWN);
+            c == KEY_PPAGE ? editorMoveCursor('k') : editorMoveCursor('j');
         }
+        break;
     }
     case KEY_HOME:
         E.cx = 0;
         break;
     case KEY_END:
-        E.cx = E.row[E.cy].size ? E.row[E.cy].size - 1 : 0;
+        if (E.cy < E.numrows)
+        {
+            Erow *row = bufferGet(&E.buf, E.cy);
+            E.cx = row->size ? row->size - 1 : 0;
+        }
         break;
     case CTRL_KEY('f'):
         editorFind();
         break;
     case KEY_RESIZE:
-        E.screenrows = LINES - 1;
-        break;
     case ERR:
         break;
     case '\r':
@@ -822,11 +1003,14 @@ void editorProcessKeypressInsert(int c)
         break;
     case CTRL_KEY('l'):
         break;
+    case KEY_PASTE:
+        editorReadPaste();
+        break;
     case KEY_EXIT:
     case 27:
         break;
     case CTRL_KEY('s'):
-        editorSave();
+        editorSavePrompt();
         break;
     case '\t':
     {
@@ -837,6 +1021,7 @@ void editorProcessKeypressInsert(int c)
         }
         break;
     }
+
     case KEY_LEFT:
     case KEY_RIGHT:
     case KEY_DOWN:
@@ -844,7 +1029,7 @@ void editorProcessKeypressInsert(int c)
         break;
     case 'j':
     {
-        int c2 = getch();
+        int c2 = editorReadKey(300);
         if (c2 == 'k')
         {
             E.mode = NORMAL;
@@ -852,21 +1037,93 @@ void editorProcessKeypressInsert(int c)
         else
         {
             editorInsertChar(c);
-            editorRefreshScreen();
+            editorUpdateScreen();
             editorProcessKeypressInsert(c2);
         }
         break;
     }
     default:
-        editorInsertChar(c);
+        /* other curses keys, like a late end of paste, are not text */
+        if (c <= 0xff)
+        {
+            editorInsertChar(c);
+        }
         break;
     }
 }
 
+/* The selection in chars, ordered and inclusive at both ends. */
+void editorSelection(int *sy, int *sx, int *ey, int *ex)
+{
+    if (E.selection_y < E.cy ||
+        (E.selection_y == E.cy && E.selection_x <= E.cx))
+    {
+        *sy = E.selection_y;
+        *sx = E.selection_x;
+        *ey = E.cy;
+        *ex = E.cx;
+    }
+    else
+    {
+        *sy = E.cy;
+        *sx = E.cx;
+        *ey = E.selection_y;
+        *ex = E.selection_x;
+    }
+}
+
+/*
+ * Runs y, d, c, > or < on the selection and leaves visual mode. A
+ * selection that reaches the end of a row takes its newline with it.
+ */
+void editorVisualAction(int c)
+{
+    Erow *row;
+    int fy, fx, ty, tx;
+
+    E.mode = NORMAL;
+    if (!E.numrows)
+    {
+        return;
+    }
+    editorSelection(&fy, &fx, &ty, &tx);
+    row = bufferGet(&E.buf, ty);
+    if (tx < row->size)
+    {
+        tx++;
+    }
+    else if (ty + 1 < E.numrows)
+    {
+        ty++;
+        tx = 0;
+    }
+    else
+    {
+        tx = row->size;
+    }
+    row = bufferGet(&E.buf, fy);
+    if (fx > row->size)
+    {
+        fx = row->size;
+    }
+
+    editorOperate(c, 0, fy, fx, ty, tx);
+}
+
 void editorProcessKeypressVisualChar(int c)
 {
     switch (c)
     {
+    case 'y':
+    case 'd':
+    case 'c':
+    case '>':
+    case '<':
+        editorVisualAction(c);
+        break;
+    case KEY_PASTE:
+        editorReadPaste();
+        break;
     case 'h':
         editorMoveCursor(c);
         break;
@@ -878,7 +1135,7 @@ void editorProcessKeypressVisualChar(int c)
         break;
     case 'j':
     {
-        int c2 = getch();
+        int c2 = editorReadKey(300);
         if (c2 == 'k')
         {
             E.mode = NORMAL;
@@ -886,7 +1143,7 @@ void editorProcessKeypressVisualChar(int c)
         else
         {
             editorMoveCursor('j');
-            editorRefreshScreen();
+            editorUpdateScreen();
             editorProcessKeypressVisualChar(c2);
         }
         break;
@@ -896,7 +1153,20 @@ void editorProcessKeypressVisualChar(int c)
 
 void editorProcessKeypress(void)
 {
-    int c = getch();
+    int c;
+
+    c = editorReadKey(editorIdleDelay());
+    /* a bracketed paste is text in every mode, never commands */
+    if (c == KEY_PASTE)
+    {
+        editorReadPaste();
+        return;
+    }
+    /* each normal mode command, with any insert it starts, is one undo */
+    if (E.mode == NORMAL && c != ERR)
+    {
+        undoBegin(&E.undo, E.cx, E.cy);
+    }
     switch (E.mode)
     {
     case NORMAL:
@@ -911,14 +1181,105 @@ void editorProcessKeypress(void)
     }
 }
 
+/*
+ * Draws the visible part of a row as runs of equal attributes, each sent
+ * with one addnstr call. Columns sel_from..sel_to - 1 of the render are
+ * selected, and the `nspans` [from, to) pairs in `spans` are matches.
+ */
+void editorDrawRow(
+    int y,
+    Erow *row,
+    int sel_from,
+    int sel_to,
+    const int *spans,
+    int nspans
+)
+{
+    const char *render = editorRenderChars(row);
+    const unsigned char *hl = editorRenderHl(row);
+    int j = E.coloff;
+    int end = editorRenderSize(row);
+    int m = 0;
+
+    if (end > E.coloff + COLS)
+    {
+        end = E.coloff + COLS;
+    }
+    while (j < end)
+    {
+        int attr;
+        int k;
+        while (m < nspans && spans[2 * m + 1] <= j)
+        {
+            m++;
+        }
+        if (j >= sel_from && j < sel_to)
+        {
+            attr = HL_SELECT;
+            k = sel_to < end ? sel_to : end;
+        }
+        else if (m < nspans && spans[2 * m] <= j)
+        {
+            attr = HL_MATCH;
+            k = spans[2 * m + 1] < end ? spans[2 * m + 1] : end;
+            if (j < sel_from && sel_from < k)
+            {
+                k = sel_from;
+            }
+        }
+        else
+        {
+            int stop = j < sel_from && sel_from < end ? sel_from : end;
+            if (m < nspans && spans[2 * m] < stop)
+            {
+                stop = spans[2 * m];
+            }
+            if (!hl)
+            {
+                attr = HL_NORMAL;
+                k = stop;
+            }
+            else
+            {
+                attr = hl[j];
+                for (k = j + 1; k < stop && hl[k] == attr; k++)
+                {
+                }
+            }
+        }
+        attron(COLOR_PAIR(attr));
+        mvaddnstr(y, j - E.coloff, &render[j], k - j);
+        attroff(COLOR_PAIR(attr));
+        j = k;
+    }
+}
+
 void editorDrawRows(void)
 {
+    double start = statsNow();
     int y;
+    int sy = -1, sx = 0, ey = -1, ex = 0;
+    BufferIter it;
+
+    if (E.mode == VISUAL_CHAR)
+    {
+        editorSelection(&sy, &sx, &ey, &ex);
+    }
 
+    editorSyntaxPrepare(E.rowoff + E.screenrows);
+    bufferIterInit(&E.buf, &it, E.rowoff);
     for (y = 0; y < E.screenrows; y++)
     {
         int filerow = y + E.rowoff;
-        if (filerow >= E.numrows)
+        Erow *row = filerow < E.numrows ? bufferIterNext(&it) : NULL;
+        if (!E.damage[y])
+        {
+            continue;
+        }
+        E.damage[y] = 0;
+        move(y, 0);
+        clrtoeol();
+        if (!row)
         {
             if (E.numrows == 0 && y == E.screenrows / 3)
             {
@@ -943,68 +1304,72 @@ void editorDrawRows(void)
         }
         else
         {
-            char *c = &E.row[filerow].render[E.coloff];
-            unsigned char *hl = &E.row[filerow].hl[E.coloff];
-            int current_color = HL_NORMAL;
-            int j;
-            int len = E.row[filerow].rsize - E.coloff;
+            int sel_from = 0;
+            int sel_to = 0;
+            int *spans = NULL;
+            int nspans = 0;
 
-            if (len < 0)
-            {
-                len = 0;
-            }
-            if (len > COLS)
+            editorRowRender(row);
+            if (E.query)
             {
-                len = COLS;
+                nspans = editorRowMatchSpans(row, &spans);
             }
-
-            for (j = 0; j < len; j++)
+            if (filerow >= sy && filerow <= ey)
             {
-                int selection_start_y =
-                    E.selection_y < E.cy ? E.selection_y : E.cy;
-                int selection_end_y =
-                    E.selection_y > E.cy ? E.selection_y : E.cy;
-                int selection_start_x =
-                    E.selection_x < E.cx ? E.selection_x : E.cx + E.coloff;
-                int selection_end_x =
-                    E.selection_x > E.cx ? E.selection_x : E.cx + E.coloff;
-                if (E.mode == VISUAL_CHAR &&
-                    (selection_start_y == selection_end_y &&
-                     y == selection_start_y && j >= selection_start_x &&
-                     j <= selection_end_x))
-                {
-                    attroff(COLOR_PAIR(current_color));
-                    current_color = HL_SELECT;
-                    attron(COLOR_PAIR(current_color));
-                }
-                else if (E.mode == VISUAL_CHAR &&
-                         selection_start_y != selection_end_y &&
-                         ((y == selection_start_y && j >= selection_start_x) ||
-                          (y == selection_end_y && j <= selection_end_x) ||
-                          (y > selection_start_y && y < selection_end_y)))
+                sel_to = editorRenderSize(row);
+                if (filerow == sy)
                 {
-                    attroff(COLOR_PAIR(current_color));
-                    current_color = HL_SELECT;
-                    attron(COLOR_PAIR(current_color));
+                    sel_from = editorRowCxToRx(row, sx);
                 }
-                else if (hl[j] != current_color)
+                if (filerow == ey && ex < row->size)
                 {
-                    attroff(COLOR_PAIR(current_color));
-                    current_color = hl[j];
-                    attron(COLOR_PAIR(current_color));
+                    sel_to = editorRowCxToRx(row, ex + 1);
                 }
-                mvaddch(y, j, c[j]);
             }
-
-            attroff(COLOR_PAIR(current_color));
+            editorDrawRow(y, row, sel_from, sel_to, spans, nspans);
         }
     }
+    statsAdd(STAT_DRAW_ROWS, start);
+}
+
+/*
+ * Draws the :stats report over the bottom right of the text, against the
+ * status bar. The rows under it are damaged again, so they are redrawn
+ * clean once it is turned off.
+ */
+void editorDrawStats(void)
+{
+    char line[128];
+    int width = 0;
+    int n = 0;
+    int top;
+    int x;
+    int k;
+
+    while (editorStatsLine(n, line, sizeof(line)))
+    {
+        int len = strlen(line) + 1;
+        width = len > width ? len : width;
+        n++;
+    }
+    width = width < COLS ? width : COLS;
+    x = COLS - width;
+    top = E.screenrows > n ? E.screenrows - n : 0;
+
+    attron(A_REVERSE);
+    for (k = 0; top + k < E.screenrows; k++)
+    {
+        editorStatsLine(k, line, sizeof(line));
+        mvprintw(top + k, x, "%-*.*s", width, width, line);
+        E.damage[top + k] = 1;
+    }
+    attroff(A_REVERSE);
 }
 
 void editorScroll(void)
 {
-    E.rx = 0;
-    E.rx = editorRowCxToRx(&E.row[E.cy], E.cx);
+    Erow *row = bufferGet(&E.buf, E.cy);
+    E.rx = row ? editorRowCxToRx(row, E.cx) : 0;
     if (E.cy < E.rowoff)
     {
         E.rowoff = E.cy;
@@ -1023,10 +1388,64 @@ void editorScroll(void)
     }
 }
 
+/*
+ * "match i/N | " on a match of the query, "N matches | " elsewhere, led
+ * by "regex | " while queries are regexes.
+ */
+void editorMatchStatus(char *s, size_t size)
+{
+    Erow *row;
+    int total;
+
+    s[0] = '\0';
+    if (E.regex_error)
+    {
+        snprintf(s, size, "regex: %s | ", E.regex_error);
+        return;
+    }
+    if (E.use_regex)
+    {
+        size_t n = snprintf(s, size, "regex | ");
+        s += n;
+        size -= n;
+    }
+    if (!E.query)
+    {
+        return;
+    }
+    if (!E.match_ready)
+    {
+        if (E.counting)
+        {
+            snprintf(s, size, "searching... | ");
+        }
+        return;
+    }
+    total = bufferMatchRank(&E.buf, E.numrows);
+    row = bufferGet(&E.buf, E.cy);
+    if (row)
+    {
+        int before = editorCountMatches(row->chars, row->size, E.cx);
+        if (editorCountMatches(row->chars, row->size, E.cx + 1) > before)
+        {
+            snprintf(
+                s,
+                size,
+                "match %d/%d | ",
+                bufferMatchRank(&E.buf, E.cy) + before + 1,
+                total
+            );
+            return;
+        }
+    }
+    snprintf(s, size, "%d matches | ", total);
+}
+
 void editorDrawStatusBar(void)
 {
-    char status[80], rstatus[80], mode[20];
+    char status[80], rstatus[80], mode[20], lines[40], match[40];
     int len, rlen;
+    int total = editorTotalRows();
     switch (E.mode)
     {
     case NORMAL:
@@ -1039,16 +1458,32 @@ void editorDrawStatusBar(void)
         snprintf(mode, sizeof(mode), "VISUAL");
         break;
     }
+    snprintf(
+        lines,
+        sizeof(lines),
+        E.indexing ? "indexing... %d lines" : "%d lines",
+        total
+    );
+    editorMatchStatus(match, sizeof(match));
     len = snprintf(
         status,
         sizeof(status),
-        "[%s] %.20s - %d lines %s",
+        "[%s] %.20s - %s %s",
         mode,
         E.filename ? E.filename : "[No Name]",
-        E.numrows,
+        lines,
         E.dirty ? "(modified)" : ""
     );
-    rlen = snprintf(rstatus, sizeof(rstatus), "%d/%d", E.cy + 1, E.numrows);
+    rlen = snprintf(
+        rstatus,
+        sizeof(rstatus),
+        "%s%s | %d/%d %d%%",
+        match,
+        E.syntax ? E.syntax->filetype : "no ft",
+        E.cy + 1,
+        total,
+        total ? (int)((E.cy + 1) * 100.0 / total) : 100
+    );
 
     attron(A_REVERSE);
     while (len < COLS)
@@ -1068,46 +1503,162 @@ void editorDrawStatusBar(void)
 
 void editorDrawMessageBar(void)
 {
-    if (time(NULL) - E.statusmsg_time < 5)
+    move(E.screenrows + 1, 0);
+    clrtoeol();
+    if (time(NULL) - E.statusmsg_time < STATUS_TIMEOUT)
+    {
+        printw("%s", E.statusmsg);
+    }
+}
+
+/*
+ * Shifts what is on screen by `delta` rows with a terminal scroll so that
+ * only the rows scrolled into view have to be drawn.
+ */
+void editorScrollScreen(int delta)
+{
+    int rows = E.screenrows;
+
+    if (delta >= rows || -delta >= rows)
+    {
+        editorDamageAll();
+        return;
+    }
+    setscrreg(0, rows - 1);
+    scrollok(stdscr, TRUE);
+    scrl(delta);
+    scrollok(stdscr, FALSE);
+    setscrreg(0, LINES - 1);
+    if (delta > 0)
+    {
+        memmove(E.damage, E.damage + delta, rows - delta);
+        memset(E.damage + rows - delta, 1, delta);
+    }
+    else
+    {
+        memmove(E.damage - delta, E.damage, rows + delta);
+        memset(E.damage, 1, -delta);
+    }
+}
+
+/*
+ * Works out which screen rows changed since the last frame beyond the ones
+ * edits already marked: everything after a resize or horizontal scroll,
+ * newly exposed rows after a vertical scroll, and the rows whose
+ * selection highlight moved with the cursor.
+ */
+void editorDamageFrame(void)
+{
+    int from;
+    int to;
+
+    if (E.mode == VISUAL_CHAR || E.drawn_mode == VISUAL_CHAR)
+    {
+        from = E.cy < E.drawn_cy ? E.cy : E.drawn_cy;
+        to = E.cy > E.drawn_cy ? E.cy : E.drawn_cy;
+        if (E.mode != E.drawn_mode)
+        {
+            from = E.selection_y < from ? E.selection_y : from;
+            to = E.selection_y > to ? E.selection_y : to;
+        }
+        editorDamageRows(from, to);
+    }
+
+    /* the stats report would scroll along with the text under it */
+    if (E.coloff != E.drawn_coloff ||
+        (E.stats_shown && E.rowoff != E.drawn_rowoff))
+    {
+        editorDamageAll();
+    }
+    else if (E.rowoff != E.drawn_rowoff)
     {
-        mvprintw(E.screenrows + 1, 0, "%s", E.statusmsg);
+        editorScrollScreen(E.rowoff - E.drawn_rowoff);
     }
+
+    E.drawn_rowoff = E.rowoff;
+    E.drawn_coloff = E.coloff;
+    E.drawn_cy = E.cy;
+    E.drawn_mode = E.mode;
 }
 
+
 void editorRefreshScreen(void)
 {
-    clear();
+    double start = statsNow();
+
+    if (LINES - 2 != E.screenrows || COLS != E.drawn_cols)
+    {
+        E.screenrows = LINES - 2;
+        E.drawn_cols = COLS;
+        E.damage = realloc(E.damage, E.screenrows);
+        editorDamageAll();
+        clear();
+    }
     editorScroll();
+    editorDamageFrame();
     editorDrawRows();
+    if (E.stats_shown)
+    {
+        editorDrawStats();
+    }
     editorDrawStatusBar();
     editorDrawMessageBar();
     move(E.cy - E.rowoff, E.rx - E.coloff);
     refresh();
+    editorTrimCache();
+    statsAdd(STAT_FRAME, start);
+    if (replaying)
+    {
+        replayDrawn(&replay);
+    }
 }
 
-void editorSetStatusMessage(const char *fmt, ...)
-{
-    va_list ap;
-    va_start(ap, fmt);
-    vsnprintf(E.statusmsg, sizeof(E.statusmsg), fmt, ap);
-    va_end(ap);
-    E.statusmsg_time = time(NULL);
-}
 
 int main(int argc, char *argv[])
 {
+    int arg = 1;
+
+    if (argc >= 3 && !strcmp(argv[1], "--replay"))
+    {
+        if (replayOpen(&replay, argv[2]) < 0)
+        {
+            perror(argv[2]);
+            return 1;
+        }
+        replaying = 1;
+        arg = 3;
+    }
     init();
-    if (argc >= 2)
+    if (argc > arg)
+    {
+        editorOpen(argv[arg]);
+    }
+    /* a replay times the editing, not the load, so it waits for the file */
+    if (replaying)
     {
-        editorOpen(argv[1]);
+        editorIndexFinish();
     }
 
-    while (1)
+    while (!E.quit)
     {
-        editorRefreshScreen();
+        editorIngest(INGEST_SLICE);
+        editorFindPoll();
+        editorUpdateScreen();
 
         editorProcessKeypress();
     }
 
+    clear();
+    endwin();
+    if (replaying)
+    {
+        replayReport(&replay, stdout);
+        replayFree(&replay);
+    }
+    else
+    {
+        fputs(PASTE_OFF, stdout);
+        fflush(stdout);
+    }
     return 0;
 }
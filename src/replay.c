@@ -0,0 +1,269 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include "replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "keys.h"
+#include "stats.h"
+
+/* indexed by Mode */
+static const char *replayModes[REPLAY_MODES] = {"normal", "insert", "visual"};
+
+/* terminal escape sequences, after the ESC, and the keys they stand for */
+static const struct
+{
+    const char *seq;
+    int key;
+} replaySeqs[] = {
+    {"[A", KEY_UP},    {"[B", KEY_DOWN},  {"[C", KEY_RIGHT},
+    {"[D", KEY_LEFT},  {"OA", KEY_UP},    {"OB", KEY_DOWN},
+    {"OC", KEY_RIGHT}, {"OD", KEY_LEFT},  {"[H", KEY_HOME},
+    {"OH", KEY_HOME},  {"[1~", KEY_HOME}, {"[7~", KEY_HOME},
+    {"[F", KEY_END},   {"OF", KEY_END},   {"[4~", KEY_END},
+    {"[8~", KEY_END},  {"[2~", KEY_IC},   {"[3~", KEY_DC},
+    {"[5~", KEY_PPAGE}, {"[6~", KEY_NPAGE}, {"[200~", KEY_PASTE},
+    {"[201~", KEY_PASTE_END},
+};
+
+/* Reads the whole log; returns -1 if it cannot be read. */
+int replayOpen(Replay *replay, const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    size_t cap = 4096;
+
+    memset(replay, 0, sizeof(*replay));
+    if (!fp)
+    {
+        return -1;
+    }
+    replay->keys = malloc(cap);
+    while (1)
+    {
+        size_t n = fread(replay->keys + replay->len, 1, cap - replay->len, fp);
+        replay->len += n;
+        if (replay->len < cap)
+        {
+            break;
+        }
+        cap *= 2;
+        replay->keys = realloc(replay->keys, cap);
+    }
+    if (ferror(fp))
+    {
+        fclose(fp);
+        replayFree(replay);
+        return -1;
+    }
+    fclose(fp);
+    return 0;
+}
+
+void replayFree(Replay *replay)
+{
+    free(replay->keys);
+    free(replay->samples);
+    free(replay->modes);
+    memset(replay, 0, sizeof(*replay));
+}
+
+static void replayClose(Replay *replay, double now)
+{
+    if (!replay->pending)
+    {
+        return;
+    }
+    replay->pending = 0;
+    if (replay->count == replay->capacity)
+    {
+        replay->capacity = replay->capacity * 2 + 1024;
+        replay->samples = realloc(
+            replay->samples,
+            sizeof(double) * replay->capacity
+        );
+        replay->modes = realloc(replay->modes, replay->capacity);
+    }
+    replay->samples[replay->count] = now - replay->start;
+    replay->modes[replay->count++] = replay->mode;
+}
+
+/*
+ * Returns the next key of the log, read in `mode`, and starts timing it;
+ * -1 once the log is used up. A newline is Enter, as it is in a terminal
+ * with nonl(), so a log can also be written by hand.
+ */
+int replayKey(Replay *replay, int mode)
+{
+    double now = statsNow();
+    int c;
+
+    replayClose(replay, now);
+    if (replay->pos == replay->len)
+    {
+        return -1;
+    }
+    if (!replay->began)
+    {
+        replay->began = now;
+    }
+    replay->start = now;
+    replay->mode = mode;
+    replay->pending = 1;
+
+    c = (unsigned char)replay->keys[replay->pos++];
+    if (c == '\n')
+    {
+        return '\r';
+    }
+    if (c == 27)
+    {
+        size_t k;
+        for (k = 0; k < sizeof(replaySeqs) / sizeof(replaySeqs[0]); k++)
+        {
+            size_t n = strlen(replaySeqs[k].seq);
+            if (replay->len - replay->pos >= n &&
+                !memcmp(replay->keys + replay->pos, replaySeqs[k].seq, n))
+            {
+                replay->pos += n;
+                return replaySeqs[k].key;
+            }
+        }
+    }
+    return c;
+}
+
+/* Ends the sample of the key being timed, now that it is on screen. */
+void replayDrawn(Replay *replay)
+{
+    replayClose(replay, statsNow());
+}
+
+static void replayRow(FILE *out, const char *name, double *sorted, int n)
+{
+    if (!n)
+    {
+        return;
+    }
+    statsSort(sorted, n);
+    fprintf(
+        out,
+        "%-8s %8d %9.3f %9.3f %9.3f\n",
+        name,
+        n,
+        statsPercentile(sorted, n, 50),
+        statsPercentile(sorted, n, 99),
+        sorted[n - 1]
+    );
+}
+
+/*
+ * Prints p50, p99 and max latency over all keys and for the keys read in
+ * each mode, then how the latencies spread over power of two buckets.
+ */
+void replayReport(Replay *replay, FILE *out)
+{
+    int buckets[REPLAY_BUCKETS];
+    double *sorted;
+    int widest = 0;
+    int first = -1;
+    int last = 0;
+    int mode;
+    int i;
+
+    replayDrawn(replay);
+    fprintf(
+        out,
+        "replayed %d keys in %.1f ms\n",
+        replay->count,
+        replay->count ? statsNow() - replay->began : 0.0
+    );
+    if (!replay->count)
+    {
+        return;
+    }
+    sorted = malloc(sizeof(double) * replay->count);
+
+    fprintf(
+        out,
+        "%-8s %8s %9s %9s %9s\n",
+        "",
+        "keys",
+        "p50 ms",
+        "p99 ms",
+        "max ms"
+    );
+    memcpy(sorted, replay->samples, sizeof(double) * replay->count);
+    replayRow(out, "all", sorted, replay->count);
+    for (mode = 0; mode < REPLAY_MODES; mode++)
+    {
+        int n = 0;
+        for (i = 0; i < replay->count; i++)
+        {
+            if (replay->modes[i] == mode)
+            {
+                sorted[n++] = replay->samples[i];
+            }
+        }
+        replayRow(out, replayModes[mode], sorted, n);
+    }
+
+    /* bucket k holds latencies below 2^k microseconds */
+    memset(buckets, 0, sizeof(buckets));
+    for (i = 0; i < replay->count; i++)
+    {
+        double us = replay->samples[i] * 1e3;
+        int k = 0;
+        while (k < REPLAY_BUCKETS - 1 && us >= (double)(1L << k))
+        {
+            k++;
+        }
+        buckets[k]++;
+    }
+    for (i = 0; i < REPLAY_BUCKETS; i++)
+    {
+        if (buckets[i])
+        {
+            first = first < 0 ? i : first;
+            last = i;
+            widest = buckets[i] > widest ? buckets[i] : widest;
+        }
+    }
+    fprintf(out, "\n");
+    for (i = first; i <= last; i++)
+    {
+        int bar = (int)((buckets[i] * 40L + widest - 1) / widest);
+        fprintf(out, "< %8.3f ms %8d", (double)(1L << i) / 1e3, buckets[i]);
+        if (bar)
+        {
+            fputc(' ', out);
+        }
+        while (bar--)
+        {
+            fputc('#', out);
+        }
+        fputc('\n', out);
+    }
+    free(sorted);
+}
@@ -0,0 +1,867 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "search.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+/* most bytes of adjacent mapped rows handed to the kernel in one call */
+#define SEARCH_SPAN (1 << 20)
+
+/*
+ * With `regex` set, matching is left to the regex. Like the needle, it
+ * is not owned by the pattern.
+ */
+void searchCompile(
+    SearchPattern *p,
+    const char *needle,
+    size_t len,
+    const Regex *regex
+)
+{
+    size_t i;
+
+    p->needle = needle;
+    p->len = len;
+    p->regex = regex;
+    /* a literal without newlines can never match across two rows */
+    p->spans = !regex && memchr(needle, '\n', len) == NULL;
+    for (i = 0; i < 256; i++)
+    {
+        p->shift[i] = len;
+    }
+    for (i = 0; i + 1 < len; i++)
+    {
+        p->shift[(unsigned char)needle[i]] = len - 1 - i;
+    }
+}
+
+static const char *searchHorspool(
+    const SearchPattern *p,
+    const char *s,
+    size_t from,
+    size_t n
+)
+{
+    size_t last = p->len - 1;
+    size_t i = from;
+
+    while (i + p->len <= n)
+    {
+        unsigned char c = s[i + last];
+        if (c == (unsigned char)p->needle[last] &&
+            !memcmp(s + i, p->needle, last))
+        {
+            return s + i;
+        }
+        i += p->shift[c];
+    }
+    return NULL;
+}
+
+/*
+ * First occurrence of the pattern in s[0, n). Sixteen candidate starts
+ * are filtered at once by comparing both the first and the last needle
+ * byte; only survivors of both compares are verified with memcmp.
+ */
+const char *searchFirst(const SearchPattern *p, const char *s, size_t n)
+{
+    size_t i = 0;
+
+    if (p->len == 0 || n < p->len)
+    {
+        return NULL;
+    }
+    if (p->len == 1)
+    {
+        return memchr(s, p->needle[0], n);
+    }
+
+#ifdef __SSE2__
+    {
+        size_t last = p->len - 1;
+        __m128i first_b = _mm_set1_epi8(p->needle[0]);
+        __m128i last_b = _mm_set1_epi8(p->needle[last]);
+        for (; i + last + 16 <= n; i += 16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(s + i));
+            __m128i b = _mm_loadu_si128((const __m128i *)(s + i + last));
+            unsigned int mask = _mm_movemask_epi8(_mm_and_si128(
+                _mm_cmpeq_epi8(a, first_b),
+                _mm_cmpeq_epi8(b, last_b)
+            ));
+            while (mask)
+            {
+                size_t pos = i + __builtin_ctz(mask);
+                if (!memcmp(s + pos + 1, p->needle + 1, last - 1))
+                {
+                    return s + pos;
+                }
+                mask &= mask - 1;
+            }
+        }
+    }
+#endif
+
+    return searchHorspool(p, s, i, n);
+}
+
+void searchMatcherInit(SearchMatcher *m, const SearchPattern *p)
+{
+    m->pattern = p;
+    if (p->regex)
+    {
+        regexMatcherInit(&m->regex, p->regex);
+    }
+}
+
+void searchMatcherFree(SearchMatcher *m)
+{
+    if (m->pattern->regex)
+    {
+        regexMatcherFree(&m->regex);
+    }
+}
+
+/*
+ * Makes s[0, size) the row that searchMatch and searchMatchEx look in,
+ * which must not change until the next call.
+ */
+void searchMatcherRow(SearchMatcher *m, const char *s, int size)
+{
+    m->s = s;
+    m->size = size;
+    if (m->pattern->regex)
+    {
+        regexMatcherRow(&m->regex, s, size);
+    }
+}
+
+/*
+ * Finds the first match in the row that starts at or after `from` and
+ * stores its extent as [start, end). Resuming at `end` walks the row's
+ * matches without overlaps, in time linear in the row. Returns 0 if
+ * there is none.
+ */
+int searchMatch(SearchMatcher *m, int from, int *start, int *end)
+{
+    const SearchPattern *p = m->pattern;
+    const char *hit;
+
+    if (p->regex)
+    {
+        return regexFind(&m->regex, from, start, end);
+    }
+    hit = searchFirst(p, m->s + from, m->size - from);
+    if (!hit)
+    {
+        return 0;
+    }
+    *start = hit - m->s;
+    *end = *start + p->len;
+    return 1;
+}
+
+/*
+ * Like searchMatch, but for :s and :g, which also take empty matches,
+ * as of ^ or x*. An empty match is only taken where no longer one
+ * starts, and never at `skip`, the end of the match before.
+ */
+int searchMatchEx(SearchMatcher *m, int from, int skip, int *start, int *end)
+{
+    const Regex *re = m->pattern->regex;
+    int size = m->size;
+    int found = searchMatch(m, from, start, end);
+    int at = from;
+
+    if (!re)
+    {
+        return found;
+    }
+    while (at <= size && (!found || at < *start))
+    {
+        if (at != skip && regexMatchesEmpty(re, at == 0, at == size))
+        {
+            *start = at;
+            *end = at;
+            return 1;
+        }
+        /* every position inside the row looks the same to an empty match */
+        if (at > 0 && at < size && at != skip &&
+            !regexMatchesEmpty(re, 0, 0))
+        {
+            at = size;
+        }
+        else
+        {
+            at++;
+        }
+    }
+    return found;
+}
+
+/* Makes room for `need` bytes in `buf`, which holds *cap. */
+static char *searchReserve(char *buf, size_t *cap, size_t need)
+{
+    if (need > *cap)
+    {
+        *cap = need * 2;
+        buf = realloc(buf, *cap);
+    }
+    return buf;
+}
+
+/*
+ * Appends the replacement for match[0, mlen) to out[0, len) and returns
+ * the new length. & stands for the match and a backslash takes the char
+ * after it literally; the result never spans rows.
+ */
+static size_t searchExpand(
+    const SearchReplace *r,
+    const char *match,
+    int mlen,
+    char **out,
+    size_t *cap,
+    size_t len
+)
+{
+    size_t i;
+
+    for (i = 0; i < r->len; i++)
+    {
+        if (r->text[i] == '&')
+        {
+            *out = searchReserve(*out, cap, len + mlen);
+            memcpy(&(*out)[len], match, mlen);
+            len += mlen;
+            continue;
+        }
+        if (r->text[i] == '\\' && i + 1 < r->len)
+        {
+            i++;
+        }
+        *out = searchReserve(*out, cap, len + 1);
+        (*out)[len++] = r->text[i];
+    }
+    return len;
+}
+
+/*
+ * Appends row s[0, size) with its matches, or only the first without
+ * r->global, replaced to edits->text and lists it as the new text of row
+ * `at`. Returns how many matches were replaced; a row without one adds
+ * nothing.
+ */
+int searchReplaceRow(
+    SearchMatcher *m,
+    const SearchReplace *r,
+    const char *s,
+    int size,
+    int at,
+    SearchEdits *edits
+)
+{
+    size_t base = edits->len;
+    size_t len = base;
+    int col = 0;
+    int skip = -1;
+    int n = 0;
+    int start, end;
+
+    searchMatcherRow(m, s, size);
+    while (col <= size && searchMatchEx(m, col, skip, &start, &end))
+    {
+        edits->text = searchReserve(
+            edits->text,
+            &edits->cap,
+            len + start - col + 1
+        );
+        memcpy(&edits->text[len], &s[col], start - col);
+        len += start - col;
+        len = searchExpand(
+            r,
+            &s[start],
+            end - start,
+            &edits->text,
+            &edits->cap,
+            len
+        );
+        n++;
+        col = end;
+        skip = end;
+        if (end == start)
+        {
+            /* step past an empty match so it is not found again */
+            if (start < size)
+            {
+                edits->text = searchReserve(edits->text, &edits->cap, len + 1);
+                edits->text[len++] = s[start];
+            }
+            col++;
+            skip = -1;
+        }
+        if (!r->global)
+        {
+            break;
+        }
+    }
+    if (!n)
+    {
+        return 0;
+    }
+    if (col < size)
+    {
+        edits->text = searchReserve(
+            edits->text,
+            &edits->cap,
+            len + size - col
+        );
+        memcpy(&edits->text[len], &s[col], size - col);
+        len += size - col;
+    }
+
+    if (edits->count == edits->capacity)
+    {
+        edits->capacity = edits->capacity * 2 + 64;
+        edits->edits = realloc(
+            edits->edits,
+            sizeof(SearchEdit) * edits->capacity
+        );
+    }
+    edits->edits[edits->count].row = at;
+    edits->edits[edits->count].len = len - base;
+    edits->edits[edits->count].off = base;
+    edits->count++;
+    edits->len = len;
+    edits->old_bytes += size;
+    edits->subs += n;
+    return n;
+}
+
+/*
+ * Rows that are views into the file mapping and follow each other in it
+ * are scanned as one block, newlines included, so the kernel sees long
+ * contiguous runs instead of one short row at a time.
+ */
+static size_t searchSpan(
+    const SearchPattern *p,
+    BufferIter *it,
+    int direction,
+    int *left,
+    const char **base
+)
+{
+    Erow *row = direction > 0 ? bufferIterNext(it) : bufferIterPrev(it);
+    size_t n = row->size;
+
+    *base = row->chars;
+    (*left)--;
+    if (!p->spans || !(row->flags & ROW_VIEW))
+    {
+        return n;
+    }
+    while (*left > 0 && n < SEARCH_SPAN)
+    {
+        BufferIter save = *it;
+        Erow *next = direction > 0 ? bufferIterNext(it) : bufferIterPrev(it);
+        if (!(next->flags & ROW_VIEW))
+        {
+            *it = save;
+            break;
+        }
+        if (direction > 0 && next->chars == *base + n + 1)
+        {
+            n += next->size + 1;
+        }
+        else if (direction < 0 && next->chars + next->size + 1 == *base)
+        {
+            *base = next->chars;
+            n += next->size + 1;
+        }
+        else
+        {
+            *it = save;
+            break;
+        }
+        (*left)--;
+    }
+    return n;
+}
+
+/* Regexes are run one row at a time; see searchCountRows. */
+static int searchCountRegex(
+    const SearchPattern *p,
+    Buffer *buf,
+    int from,
+    int to,
+    int direction,
+    SearchPos *pos
+)
+{
+    SearchMatcher m;
+    BufferIter it;
+    int found = 0;
+    int at;
+
+    searchMatcherInit(&m, p);
+    bufferIterInit(buf, &it, from);
+    for (at = from; at < to; at++)
+    {
+        Erow *row = bufferIterNext(&it);
+        int start;
+        int end = 0;
+
+        row->matches = 0;
+        searchMatcherRow(&m, row->chars, row->size);
+        while (searchMatch(&m, end, &start, &end))
+        {
+            if (!found || direction < 0)
+            {
+                pos->row = at;
+                pos->col = start;
+                found = 1;
+            }
+            row->matches++;
+        }
+    }
+    searchMatcherFree(&m);
+    return found;
+}
+
+/*
+ * Sets the match count of every row in [from, to), counting matches that
+ * do not overlap from the left, and stores the first (direction > 0) or
+ * last (direction < 0) match found. Returns 0 if there is none.
+ */
+int searchCountRows(
+    const SearchPattern *p,
+    Buffer *buf,
+    int from,
+    int to,
+    int direction,
+    SearchPos *pos
+)
+{
+    BufferIter it;
+    int left = to - from;
+    int found = 0;
+
+    if (p->regex)
+    {
+        return searchCountRegex(p, buf, from, to, direction, pos);
+    }
+    if (left <= 0 || p->len == 0)
+    {
+        return 0;
+    }
+    bufferIterInit(buf, &it, from);
+    while (left > 0)
+    {
+        BufferIter walk = it;
+        int at = to - left;
+        const char *base;
+        size_t n = searchSpan(p, &it, 1, &left, &base);
+        int last = to - left - 1;
+        Erow *row = bufferIterNext(&walk);
+        size_t row_start = 0;
+        size_t off = 0;
+        const char *hit;
+
+        row->matches = 0;
+        while ((hit = searchFirst(p, base + off, n - off)))
+        {
+            size_t col = hit - base;
+            while (col > row_start + row->size)
+            {
+                row_start += row->size + 1;
+                row = bufferIterNext(&walk);
+                row->matches = 0;
+                at++;
+            }
+            if (!found || direction < 0)
+            {
+                pos->row = at;
+                pos->col = col - row_start;
+                found = 1;
+            }
+            row->matches++;
+            off = col + p->len;
+        }
+        while (at < last)
+        {
+            row = bufferIterNext(&walk);
+            row->matches = 0;
+            at++;
+        }
+    }
+    return found;
+}
+
+/* Collects the rows of a chunk that pool->replace changes. */
+static void searchChunkReplace(SearchPool *pool, SearchChunk *chunk)
+{
+    SearchMatcher m;
+    BufferIter it;
+    int at;
+
+    searchMatcherInit(&m, &pool->pattern);
+    bufferIterInit(pool->buf, &it, chunk->from);
+    for (at = chunk->from; at < chunk->to; at++)
+    {
+        Erow *row = bufferIterNext(&it);
+        searchReplaceRow(
+            &m,
+            pool->replace,
+            row->chars,
+            row->size,
+            at,
+            &chunk->edits
+        );
+    }
+    searchMatcherFree(&m);
+}
+
+static void searchChunkRun(SearchPool *pool, int k)
+{
+    SearchChunk *chunk = &pool->chunks[k];
+    SearchPos pos;
+
+    if (pool->replace)
+    {
+        searchChunkReplace(pool, chunk);
+        __atomic_store_n(&chunk->state, SEARCH_NONE, __ATOMIC_RELEASE);
+    }
+    else if (searchCountRows(
+            &pool->pattern,
+            pool->buf,
+            chunk->from,
+            chunk->to,
+            pool->direction,
+            &pos
+        ))
+    {
+        chunk->pos = pos;
+        __atomic_store_n(&chunk->state, SEARCH_FOUND, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        __atomic_store_n(&chunk->state, SEARCH_NONE, __ATOMIC_RELEASE);
+    }
+    __atomic_add_fetch(&pool->finished, 1, __ATOMIC_RELEASE);
+}
+
+static void searchPoolDrain(SearchPool *pool)
+{
+    while (!__atomic_load_n(&pool->cancel, __ATOMIC_RELAXED))
+    {
+        int k = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+        if (k >= pool->nchunks)
+        {
+            break;
+        }
+        searchChunkRun(pool, k);
+    }
+}
+
+static void *searchWorker(void *arg)
+{
+    SearchPool *pool = arg;
+    int seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1)
+    {
+        while (!pool->quit && (!pool->running || seen == pool->generation))
+        {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->quit)
+        {
+            break;
+        }
+        seen = pool->generation;
+        pool->active++;
+        pthread_mutex_unlock(&pool->lock);
+
+        searchPoolDrain(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0)
+        {
+            pthread_cond_signal(&pool->idle);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+void searchPoolInit(SearchPool *pool)
+{
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+}
+
+/* Threads are only started by the first search big enough to need them. */
+static int searchPoolSpawn(SearchPool *pool)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cpus > SEARCH_THREADS_MAX)
+    {
+        cpus = SEARCH_THREADS_MAX;
+    }
+    while (pool->nthreads < cpus &&
+           pthread_create(
+               &pool->threads[pool->nthreads],
+               NULL,
+               searchWorker,
+               pool
+           ) == 0)
+    {
+        pool->nthreads++;
+    }
+    return pool->nthreads > 0;
+}
+
+static int searchPoolSplit(SearchPool *pool, int k, int from, int to)
+{
+    int r;
+
+    if (pool->direction > 0)
+    {
+        for (r = from; r < to; r += SEARCH_CHUNK_ROWS)
+        {
+            pool->chunks[k].from = r;
+            pool->chunks[k].to = to - r > SEARCH_CHUNK_ROWS
+                                     ? r + SEARCH_CHUNK_ROWS
+                                     : to;
+            k++;
+        }
+    }
+    else
+    {
+        for (r = to; r > from; r -= SEARCH_CHUNK_ROWS)
+        {
+            pool->chunks[k].from = r - from > SEARCH_CHUNK_ROWS
+                                       ? r - SEARCH_CHUNK_ROWS
+                                       : from;
+            pool->chunks[k].to = r;
+            k++;
+        }
+    }
+    return k;
+}
+
+/*
+ * Starts looking for `pattern` from row `from` in `direction`, wrapping
+ * around the end of the buffer: forward covers [from, numrows) and then
+ * [0, from), backward covers [0, from) and then [from, numrows), each
+ * from its far end. Small buffers are searched before this returns. The
+ * pattern is copied, but what it points to must outlive the search.
+ */
+void searchPoolStart(
+    SearchPool *pool,
+    Buffer *buf,
+    const SearchPattern *pattern,
+    int from,
+    int direction
+)
+{
+    int n = buf->numrows;
+    int k = 0;
+
+    searchPoolCancel(pool);
+    pool->pattern = *pattern;
+    pool->buf = buf;
+    pool->direction = direction;
+
+    pool->chunks = realloc(
+        pool->chunks,
+        sizeof(SearchChunk) * (n / SEARCH_CHUNK_ROWS + 2)
+    );
+    if (direction > 0)
+    {
+        k = searchPoolSplit(pool, k, from, n);
+        k = searchPoolSplit(pool, k, 0, from);
+    }
+    else
+    {
+        k = searchPoolSplit(pool, k, 0, from);
+        k = searchPoolSplit(pool, k, from, n);
+    }
+    pool->nchunks = k;
+    for (k = 0; k < pool->nchunks; k++)
+    {
+        pool->chunks[k].state = SEARCH_RUNNING;
+    }
+    pool->next = 0;
+    pool->finished = 0;
+    pool->resolved = 0;
+    pool->cancel = 0;
+
+    if (n <= SEARCH_CHUNK_ROWS || !searchPoolSpawn(pool))
+    {
+        searchPoolDrain(pool);
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->running = 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * SEARCH_FOUND with the position of the preferred match, SEARCH_NONE if
+ * there is none, or SEARCH_RUNNING while that is not yet decided.
+ */
+int searchPoolPoll(SearchPool *pool, SearchPos *pos)
+{
+    while (pool->resolved < pool->nchunks)
+    {
+        SearchChunk *chunk = &pool->chunks[pool->resolved];
+        int state = __atomic_load_n(&chunk->state, __ATOMIC_ACQUIRE);
+        if (state == SEARCH_FOUND)
+        {
+            *pos = chunk->pos;
+            return SEARCH_FOUND;
+        }
+        if (state != SEARCH_NONE)
+        {
+            return SEARCH_RUNNING;
+        }
+        pool->resolved++;
+    }
+    return SEARCH_NONE;
+}
+
+/* Whether every row's match count has been set. */
+int searchPoolDone(SearchPool *pool)
+{
+    return __atomic_load_n(&pool->finished, __ATOMIC_ACQUIRE) ==
+           pool->nchunks;
+}
+
+/* Stops the current search and waits until no worker touches the buffer. */
+void searchPoolCancel(SearchPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->running = 0;
+    __atomic_store_n(&pool->cancel, 1, __ATOMIC_RELAXED);
+    while (pool->active)
+    {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * Runs `replace` over rows [from, to) in chunks on every worker and on
+ * this thread too, and returns once all are done with the changed rows
+ * in `out`, in row order; the caller frees out->edits and out->text.
+ * The buffer is only read, so committing the edits is left to the
+ * caller.
+ */
+void searchPoolReplace(
+    SearchPool *pool,
+    Buffer *buf,
+    const SearchPattern *pattern,
+    const SearchReplace *replace,
+    int from,
+    int to,
+    SearchEdits *out
+)
+{
+    int k;
+
+    searchPoolCancel(pool);
+    pool->pattern = *pattern;
+    pool->buf = buf;
+    pool->direction = 1;
+    pool->replace = replace;
+
+    pool->chunks = realloc(
+        pool->chunks,
+        sizeof(SearchChunk) * ((to - from) / SEARCH_CHUNK_ROWS + 1)
+    );
+    pool->nchunks = searchPoolSplit(pool, 0, from, to);
+    for (k = 0; k < pool->nchunks; k++)
+    {
+        pool->chunks[k].state = SEARCH_RUNNING;
+        memset(&pool->chunks[k].edits, 0, sizeof(SearchEdits));
+    }
+    pool->next = 0;
+    pool->finished = 0;
+    pool->resolved = 0;
+    pool->cancel = 0;
+
+    if (to - from > SEARCH_CHUNK_ROWS && searchPoolSpawn(pool))
+    {
+        pthread_mutex_lock(&pool->lock);
+        pool->running = 1;
+        pool->generation++;
+        pthread_cond_broadcast(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    searchPoolDrain(pool);
+    /* every chunk is taken; wait for the workers to finish theirs */
+    searchPoolCancel(pool);
+    pool->replace = NULL;
+
+    memset(out, 0, sizeof(*out));
+    for (k = 0; k < pool->nchunks; k++)
+    {
+        SearchEdits *edits = &pool->chunks[k].edits;
+        out->count += edits->count;
+        out->len += edits->len;
+        out->old_bytes += edits->old_bytes;
+        out->subs += edits->subs;
+    }
+    out->capacity = out->count;
+    out->cap = out->len;
+    out->edits = malloc(sizeof(SearchEdit) * (out->count + 1));
+    out->text = malloc(out->len + 1);
+    out->count = 0;
+    out->len = 0;
+    for (k = 0; k < pool->nchunks; k++)
+    {
+        SearchEdits *edits = &pool->chunks[k].edits;
+        int i;
+        for (i = 0; i < edits->count; i++)
+        {
+            out->edits[out->count] = edits->edits[i];
+            out->edits[out->count++].off += out->len;
+        }
+        if (edits->len)
+        {
+            memcpy(&out->text[out->len], edits->text, edits->len);
+            out->len += edits->len;
+        }
+        free(edits->edits);
+        free(edits->text);
+    }
+}
@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "slab.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void slabInit(Slab *slab)
+{
+    memset(slab, 0, sizeof(*slab));
+}
+
+void slabFree(Slab *slab)
+{
+    int k;
+    for (k = 0; k < slab->nslabs; k++)
+    {
+        free(slab->slabs[k]);
+    }
+    free(slab->slabs);
+    slabInit(slab);
+}
+
+/* The size of the class that holds `size` bytes. */
+static size_t slabClassSize(size_t size)
+{
+    size_t c = SLAB_MIN;
+    while (c < size)
+    {
+        c *= 2;
+    }
+    return c;
+}
+
+static int slabClass(size_t c)
+{
+    int k = 0;
+    while ((size_t)SLAB_MIN << k < c)
+    {
+        k++;
+    }
+    return k;
+}
+
+/* Room for at least `size` bytes, held as the class `size` falls in. */
+char *slabAlloc(Slab *slab, size_t size)
+{
+    size_t c = slabClassSize(size);
+    char *p;
+    int k;
+
+    slab->allocs++;
+    slab->live += c;
+    if (c > SLAB_MAX)
+    {
+        return malloc(c);
+    }
+    k = slabClass(c);
+    if (slab->free[k])
+    {
+        p = slab->free[k];
+        memcpy(&slab->free[k], p, sizeof(char *));
+        return p;
+    }
+    if (slab->left < c)
+    {
+        /* the tail of the old slab is smaller than any block still to come */
+        if (slab->nslabs == slab->capacity)
+        {
+            slab->capacity = slab->capacity * 2 + 16;
+            slab->slabs = realloc(
+                slab->slabs,
+                sizeof(char *) * slab->capacity
+            );
+        }
+        slab->top = malloc(SLAB_SIZE);
+        slab->slabs[slab->nslabs++] = slab->top;
+        slab->left = SLAB_SIZE;
+    }
+    p = slab->top;
+    slab->top += c;
+    slab->left -= c;
+    return p;
+}
+
+/* Gives back a block that holds `size` bytes. */
+void slabRelease(Slab *slab, char *p, size_t size)
+{
+    size_t c = slabClassSize(size);
+    int k;
+
+    slab->live -= c;
+    if (c > SLAB_MAX)
+    {
+        free(p);
+        return;
+    }
+    k = slabClass(c);
+    memcpy(p, &slab->free[k], sizeof(char *));
+    slab->free[k] = p;
+}
+
+/*
+ * Makes the block at `p`, which holds `old` bytes, hold `size` instead,
+ * keeping what fits. The block only moves when its class changes.
+ */
+char *slabResize(Slab *slab, char *p, size_t old, size_t size)
+{
+    size_t from = slabClassSize(old);
+    size_t to = slabClassSize(size);
+    char *q;
+
+    if (from == to)
+    {
+        return p;
+    }
+    if (from > SLAB_MAX && to > SLAB_MAX)
+    {
+        slab->allocs++;
+        slab->live += to - from;
+        return realloc(p, to);
+    }
+    q = slabAlloc(slab, size);
+    memcpy(q, p, old < size ? old : size);
+    slabRelease(slab, p, old);
+    return q;
+}
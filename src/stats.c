@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+
+#include "stats.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+Stat stats[STATS] = {
+    {"update row", 0, 0, 0},
+    {"insert rows", 0, 0, 0},
+    {"delete rows", 0, 0, 0},
+    {"open", 0, 0, 0},
+    {"save", 0, 0, 0},
+    {"find", 0, 0, 0},
+    {"draw rows", 0, 0, 0},
+    {"frame", 0, 0, 0},
+};
+
+/* Milliseconds on the monotonic clock. */
+double statsNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int statsCompare(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Sorts `n` latency samples in place, for statsPercentile. */
+void statsSort(double *samples, int n)
+{
+    qsort(samples, n, sizeof(double), statsCompare);
+}
+
+/* The sample that `pct` percent of the `n` sorted samples are at or below. */
+double statsPercentile(const double *sorted, int n, int pct)
+{
+    int k = (pct * n + 99) / 100 - 1;
+    return sorted[k < 0 ? 0 : k];
+}
+
+/* Counts a call to `id` that began at `start`. */
+void statsAdd(int id, double start)
+{
+    double ms = statsNow() - start;
+    stats[id].calls++;
+    stats[id].ms += ms;
+    if (ms > stats[id].max)
+    {
+        stats[id].max = ms;
+    }
+}
@@ -0,0 +1,257 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "syntax.h"
+
+#include <ctype.h>
+#include <stddef.h>
+#include <string.h>
+
+static const char *C_HL_extensions[] = {
+    ".c",
+    ".h",
+    ".cpp",
+    ".cc",
+    ".hpp",
+    NULL,
+};
+static const char *C_HL_keywords[] = {
+    "switch",   "if",        "while",   "for",     "break",   "continue",
+    "return",   "else",      "struct",  "union",   "typedef", "static",
+    "enum",     "class",     "case",    "default", "do",      "goto",
+    "sizeof",   "#include",  "#define", "#ifdef",  "#ifndef", "#endif",
+    "#if",      "#else",     "int|",    "long|",   "double|", "float|",
+    "char|",    "unsigned|", "signed|", "void|",   "const|",  "short|",
+    "size_t|",  "extern|",   "NULL|",   NULL,
+};
+
+static const char *PY_HL_extensions[] = {
+    ".py",
+    NULL,
+};
+static const char *PY_HL_keywords[] = {
+    "def",   "class", "return", "if",    "elif",   "else",     "for",
+    "while", "break", "import", "from",  "as",     "pass",     "with",
+    "try",   "in",    "not",    "and",   "or",     "continue", "except",
+    "raise", "yield", "lambda", "None|", "True|",  "False|",   "self|",
+    "int|",  "str|",  "list|",  "dict|", "float|", NULL,
+};
+
+static const EditorSyntax HLDB[] = {
+    {"c",
+     C_HL_extensions,
+     C_HL_keywords,
+     "//",
+     "/*",
+     "*/",
+     HL_HIGHLIGHT_NUMBERS | HL_HIGHLIGHT_STRINGS},
+    {"python",
+     PY_HL_extensions,
+     PY_HL_keywords,
+     "#",
+     NULL,
+     NULL,
+     HL_HIGHLIGHT_NUMBERS | HL_HIGHLIGHT_STRINGS},
+};
+
+#define HLDB_ENTRIES (sizeof(HLDB) / sizeof(HLDB[0]))
+
+const EditorSyntax *syntaxSelect(const char *filename)
+{
+    const char *ext;
+    unsigned int j;
+
+    if (!filename)
+    {
+        return NULL;
+    }
+    ext = strrchr(filename, '.');
+    if (!ext)
+    {
+        return NULL;
+    }
+    for (j = 0; j < HLDB_ENTRIES; j++)
+    {
+        int i;
+        for (i = 0; HLDB[j].filematch[i]; i++)
+        {
+            if (!strcmp(ext, HLDB[j].filematch[i]))
+            {
+                return &HLDB[j];
+            }
+        }
+    }
+    return NULL;
+}
+
+static int isSeparator(int c)
+{
+    return isspace(c) || c == '\0' || strchr(",.()+-/*=~%<>[];{}", c) != NULL;
+}
+
+static int startsWith(const char *s, int size, int i, const char *p, int len)
+{
+    return len && i + len <= size && !memcmp(&s[i], p, len);
+}
+
+/*
+ * Highlights one row of `size` chars that starts in `state` and returns
+ * the state carried into the next row. With a NULL `hl` only comments and
+ * strings are tracked, which is all the carried state depends on; this
+ * is what the editor uses to walk state through rows it does not draw.
+ */
+int syntaxHighlight(
+    const EditorSyntax *syntax,
+    const char *s,
+    int size,
+    int state,
+    unsigned char *hl
+)
+{
+    const char *scs = syntax->singleline_comment_start;
+    const char *mcs = syntax->multiline_comment_start;
+    const char *mce = syntax->multiline_comment_end;
+    int scs_len = scs ? strlen(scs) : 0;
+    int mcs_len = mcs ? strlen(mcs) : 0;
+    int mce_len = mce ? strlen(mce) : 0;
+    int prev_sep = 1;
+    int prev_hl = HL_NORMAL;
+    int in_string = 0;
+    int in_comment = state == HL_STATE_COMMENT;
+    int i = 0;
+
+    while (i < size)
+    {
+        unsigned char c = s[i];
+
+        if (!in_string && !in_comment && startsWith(s, size, i, scs, scs_len))
+        {
+            if (hl)
+            {
+                memset(&hl[i], HL_COMMENT, size - i);
+            }
+            break;
+        }
+
+        if (mcs_len && mce_len && !in_string)
+        {
+            if (in_comment)
+            {
+                int len = 1;
+                if (startsWith(s, size, i, mce, mce_len))
+                {
+                    len = mce_len;
+                    in_comment = 0;
+                    prev_sep = 1;
+                }
+                if (hl)
+                {
+                    memset(&hl[i], HL_MLCOMMENT, len);
+                }
+                i += len;
+                continue;
+            }
+            else if (startsWith(s, size, i, mcs, mcs_len))
+            {
+                if (hl)
+                {
+                    memset(&hl[i], HL_MLCOMMENT, mcs_len);
+                }
+                i += mcs_len;
+                in_comment = 1;
+                continue;
+            }
+        }
+
+        if (syntax->flags & HL_HIGHLIGHT_STRINGS)
+        {
+            if (in_string)
+            {
+                int len = c == '\\' && i + 1 < size ? 2 : 1;
+                if (hl)
+                {
+                    memset(&hl[i], HL_STRING, len);
+                }
+                if (c == in_string)
+                {
+                    in_string = 0;
+                }
+                i += len;
+                prev_sep = 1;
+                continue;
+            }
+            else if (c == '"' || c == '\'')
+            {
+                in_string = c;
+                if (hl)
+                {
+                    hl[i] = HL_STRING;
+                }
+                i++;
+                continue;
+            }
+        }
+
+        if (hl)
+        {
+            prev_hl = i > 0 ? hl[i - 1] : HL_NORMAL;
+            if ((syntax->flags & HL_HIGHLIGHT_NUMBERS) &&
+                ((isdigit(c) && (prev_sep || prev_hl == HL_NUMBER)) ||
+                 (c == '.' && prev_hl == HL_NUMBER)))
+            {
+                hl[i] = HL_NUMBER;
+                i++;
+                prev_sep = 0;
+                continue;
+            }
+
+            if (prev_sep)
+            {
+                int j;
+                for (j = 0; syntax->keywords[j]; j++)
+                {
+                    int klen = strlen(syntax->keywords[j]);
+                    int kw2 = syntax->keywords[j][klen - 1] == '|';
+                    if (kw2)
+                    {
+                        klen--;
+                    }
+                    if (startsWith(s, size, i, syntax->keywords[j], klen) &&
+                        (i + klen == size ||
+                         isSeparator((unsigned char)s[i + klen])))
+                    {
+                        memset(&hl[i], kw2 ? HL_KEYWORD2 : HL_KEYWORD1, klen);
+                        i += klen;
+                        break;
+                    }
+                }
+                if (syntax->keywords[j])
+                {
+                    prev_sep = 0;
+                    continue;
+                }
+            }
+        }
+
+        prev_sep = isSeparator(c);
+        i++;
+    }
+
+    return in_comment ? HL_STATE_COMMENT : HL_STATE_NORMAL;
+}
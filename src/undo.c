@@ -0,0 +1,247 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "undo.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void undoInit(UndoLog *log, size_t limit)
+{
+    memset(log, 0, sizeof(*log));
+    log->limit = limit;
+}
+
+void undoFree(UndoLog *log)
+{
+    int k;
+    for (k = 0; k < log->nchunks; k++)
+    {
+        free(log->chunks[k]);
+    }
+    free(log->chunks);
+    free(log->used);
+    free(log->sizes);
+    free(log->ops);
+    undoInit(log, log->limit);
+}
+
+/* Later edits go into a new group that undoes back to cursor cx, cy. */
+void undoBegin(UndoLog *log, int cx, int cy)
+{
+    log->open = 0;
+    log->cx = cx;
+    log->cy = cy;
+}
+
+static char *undoAlloc(UndoLog *log, size_t len, int *chunk)
+{
+    int k = log->nchunks - 1;
+
+    if (k < 0 || log->used[k] + len > log->sizes[k])
+    {
+        size_t size = len > UNDO_CHUNK ? len : UNDO_CHUNK;
+        if (log->nchunks == log->chunk_capacity)
+        {
+            log->chunk_capacity = log->chunk_capacity * 2 + 8;
+            log->chunks = realloc(
+                log->chunks,
+                sizeof(char *) * log->chunk_capacity
+            );
+            log->used = realloc(
+                log->used,
+                sizeof(size_t) * log->chunk_capacity
+            );
+            log->sizes = realloc(
+                log->sizes,
+                sizeof(size_t) * log->chunk_capacity
+            );
+        }
+        k = log->nchunks++;
+        log->chunks[k] = malloc(size);
+        log->used[k] = 0;
+        log->sizes[k] = size;
+        log->bytes += size;
+    }
+    *chunk = log->base + k;
+    log->used[k] += len;
+    return log->chunks[k] + log->used[k] - len;
+}
+
+/* Forgets the undone ops, giving their bytes back to the arena. */
+static void undoTruncate(UndoLog *log)
+{
+    UndoOp *cut;
+    int k;
+
+    if (log->done == log->count)
+    {
+        return;
+    }
+    cut = &log->ops[log->done];
+    k = cut->chunk - log->base;
+    log->used[k] = cut->text - log->chunks[k];
+    while (log->nchunks > k + 1)
+    {
+        log->nchunks--;
+        log->bytes -= log->sizes[log->nchunks];
+        free(log->chunks[log->nchunks]);
+    }
+    log->count = log->done;
+}
+
+/*
+ * Drops the oldest groups while the log is over its limit. The group
+ * being recorded is always kept, however large it is.
+ */
+static void undoTrim(UndoLog *log)
+{
+    int drop;
+
+    while (log->bytes + sizeof(UndoOp) * (log->count - log->head) >
+               log->limit &&
+           log->ops[log->head].group != log->group)
+    {
+        unsigned long group = log->ops[log->head].group;
+        while (log->ops[log->head].group == group)
+        {
+            log->head++;
+        }
+    }
+
+    drop = log->ops[log->head].chunk - log->base;
+    if (drop > 0)
+    {
+        int k;
+        for (k = 0; k < drop; k++)
+        {
+            log->bytes -= log->sizes[k];
+            free(log->chunks[k]);
+        }
+        log->nchunks -= drop;
+        memmove(log->chunks, log->chunks + drop, sizeof(char *) * log->nchunks);
+        memmove(log->used, log->used + drop, sizeof(size_t) * log->nchunks);
+        memmove(log->sizes, log->sizes + drop, sizeof(size_t) * log->nchunks);
+        log->base += drop;
+    }
+    if (log->head > log->count / 2)
+    {
+        log->count -= log->head;
+        log->done -= log->head;
+        memmove(log->ops, log->ops + log->head, sizeof(UndoOp) * log->count);
+        log->head = 0;
+    }
+}
+
+/*
+ * Records an op and returns room for its `len` bytes, which the caller
+ * fills in; NULL while undo or redo is replaying ops. Text typed at the
+ * end of the previous insert of the same group extends that insert.
+ */
+char *undoPush(UndoLog *log, int type, int at, int col, int n, size_t len)
+{
+    UndoOp *op;
+    char *text;
+
+    if (log->replaying)
+    {
+        return NULL;
+    }
+    undoTruncate(log);
+
+    if (log->open && type == UNDO_INSERT_TEXT && log->count > log->head)
+    {
+        int k = log->nchunks - 1;
+        op = &log->ops[log->count - 1];
+        if (op->type == UNDO_INSERT_TEXT && op->at == at &&
+            op->col + (int)op->len == col && op->chunk == log->base + k &&
+            op->text + op->len == log->chunks[k] + log->used[k] &&
+            log->used[k] + len <= log->sizes[k])
+        {
+            log->used[k] += len;
+            op->len += len;
+            return op->text + op->len - len;
+        }
+    }
+
+    if (!log->open)
+    {
+        log->group++;
+        log->open = 1;
+    }
+    if (log->count == log->capacity)
+    {
+        log->capacity = log->capacity * 2 + 16;
+        log->ops = realloc(log->ops, sizeof(UndoOp) * log->capacity);
+    }
+    op = &log->ops[log->count++];
+    op->type = type;
+    op->at = at;
+    op->col = col;
+    op->n = n;
+    op->len = len;
+    op->text = undoAlloc(log, len, &op->chunk);
+    op->cx = log->cx;
+    op->cy = log->cy;
+    op->group = log->group;
+    log->done = log->count;
+
+    text = op->text;
+    undoTrim(log);
+    return text;
+}
+
+/*
+ * Moves back (direction < 0) or forward over one group and points `ops`
+ * at it. Undo applies the inverse of each op from the last, redo the ops
+ * themselves from the first. Returns the number of ops, 0 at either end.
+ */
+int undoStep(UndoLog *log, int direction, UndoOp **ops)
+{
+    unsigned long group;
+    int from = log->done;
+
+    log->open = 0;
+    if (direction < 0)
+    {
+        if (log->done == log->head)
+        {
+            return 0;
+        }
+        group = log->ops[log->done - 1].group;
+        while (log->done > log->head && log->ops[log->done - 1].group == group)
+        {
+            log->done--;
+        }
+        *ops = &log->ops[log->done];
+        return from - log->done;
+    }
+    if (log->done == log->count)
+    {
+        return 0;
+    }
+    group = log->ops[log->done].group;
+    while (log->done < log->count && log->ops[log->done].group == group)
+    {
+        log->done++;
+    }
+    *ops = &log->ops[from];
+    return log->done - from;
+}
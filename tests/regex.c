@@ -0,0 +1,190 @@
+/**
+ * Copyright (C) 2024 Devin Rockwell
+ *
+ * This file is part of ocean.
+ *
+ * ocean is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ocean is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ocean.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "search.h"
+#include "stats.h"
+
+/*
+ * Walks the regex matches of rows through the search API and checks
+ * what is found, then times patterns whose forward pass once ran to the
+ * end of the row for every match, on rows long enough that a scan
+ * quadratic in the row could not finish inside the limit.
+ */
+#define TEST_MS 2000.0
+#define TEST_LONG_ROW 100000
+#define TEST_ROWS 200
+#define TEST_ROW 20000
+
+static int failures = 0;
+
+static Regex *testCompile(const char *pattern, SearchPattern *p)
+{
+    const char *error;
+    Regex *re = regexCompile(pattern, strlen(pattern), &error);
+
+    if (!re)
+    {
+        fprintf(stderr, "%s: %s\n", pattern, error);
+        exit(1);
+    }
+    searchCompile(p, pattern, strlen(pattern), re);
+    return re;
+}
+
+/* Matches of `pattern` in `row`, as "start-end " pairs, against `want`. */
+static void testMatches(const char *pattern, const char *row, const char *want)
+{
+    SearchPattern p;
+    SearchMatcher m;
+    Regex *re = testCompile(pattern, &p);
+    char got[256];
+    size_t len = 0;
+    int start;
+    int end = 0;
+
+    got[0] = '\0';
+    searchMatcherInit(&m, &p);
+    searchMatcherRow(&m, row, strlen(row));
+    while (searchMatch(&m, end, &start, &end) && len + 24 < sizeof(got))
+    {
+        len += sprintf(&got[len], "%d-%d ", start, end);
+    }
+    if (strcmp(got, want))
+    {
+        fprintf(
+            stderr,
+            "/%s/ on \"%s\": got \"%s\", want \"%s\"\n",
+            pattern,
+            row,
+            got,
+            want
+        );
+        failures++;
+    }
+    searchMatcherFree(&m);
+    regexFree(re);
+}
+
+static void testTime(const char *what, double start)
+{
+    double spent = statsNow() - start;
+
+    if (spent > TEST_MS)
+    {
+        fprintf(stderr, "%s took %.0fms\n", what, spent);
+        failures++;
+    }
+}
+
+/* Counts the matches of `pattern` in one long row of a's. */
+static void testLongRow(const char *pattern, int want)
+{
+    SearchPattern p;
+    SearchMatcher m;
+    Regex *re = testCompile(pattern, &p);
+    char *row = malloc(TEST_LONG_ROW);
+    double start = statsNow();
+    int count = 0;
+    int from;
+    int end = 0;
+
+    memset(row, 'a', TEST_LONG_ROW);
+    searchMatcherInit(&m, &p);
+    searchMatcherRow(&m, row, TEST_LONG_ROW);
+    while (searchMatch(&m, end, &from, &end))
+    {
+        count++;
+    }
+    testTime(pattern, start);
+    if (count != want)
+    {
+        fprintf(stderr, "/%s/: %d matches, want %d\n", pattern, count, want);
+        failures++;
+    }
+    searchMatcherFree(&m);
+    free(row);
+    regexFree(re);
+}
+
+/* :%s/a*b|a/X/g over rows of a's, as the search pool runs it. */
+static void testReplace(void)
+{
+    SearchPattern p;
+    SearchMatcher m;
+    SearchReplace r;
+    SearchEdits edits;
+    Regex *re = testCompile("a*b|a", &p);
+    char *row = malloc(TEST_ROW);
+    double start = statsNow();
+    long subs = 0;
+    int at;
+
+    memset(row, 'a', TEST_ROW);
+    memset(&edits, 0, sizeof(edits));
+    r.text = "X";
+    r.len = 1;
+    r.global = 1;
+    searchMatcherInit(&m, &p);
+    for (at = 0; at < TEST_ROWS; at++)
+    {
+        subs += searchReplaceRow(&m, &r, row, TEST_ROW, at, &edits);
+    }
+    testTime(":%s/a*b|a/X/g", start);
+    if (subs != (long)TEST_ROWS * TEST_ROW)
+    {
+        fprintf(stderr, ":%%s made %ld substitutions\n", subs);
+        failures++;
+    }
+    searchMatcherFree(&m);
+    free(edits.edits);
+    free(edits.text);
+    free(row);
+    regexFree(re);
+}
+
+int main(void)
+{
+    testMatches("a*b|a", "aab", "0-3 ");
+    testMatches("a*b|a", "aaxab", "0-1 1-2 3-5 ");
+    testMatches("(a|ab)(c|bcd)", "abcd", "0-4 ");
+    testMatches("x*", "axxbx", "1-3 4-5 ");
+    testMatches("^a|b$", "aab", "0-1 2-3 ");
+    testMatches("\\d+", "a12b345", "1-3 4-7 ");
+    testMatches("a$", "aaa", "2-3 ");
+    testMatches("b", "aaa", "");
+
+    testLongRow("a*b|a", TEST_LONG_ROW);
+    testLongRow("(a|aa)*b|a", TEST_LONG_ROW);
+    testLongRow("a*c|a*b", 0);
+    testLongRow("a*$", 1);
+    testReplace();
+
+    if (failures)
+    {
+        fprintf(stderr, "%d failed\n", failures);
+        return 1;
+    }
+    return 0;
+}